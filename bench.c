@@ -0,0 +1,645 @@
+#include "maze.h"
+#include "play.h"
+#include "reach.h"
+#include "sim.h"
+#include "globals.h"
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------BENCHMARK SUITE---------------------------------------
+// build: gcc -O2 -pthread bench.c -o bench, and run it from the directory with the game's text files.
+// usage: bench [--quick] [--config <name>] [--save-baseline <file>] [--baseline <file>] [--threshold <percent>]
+// times the hot functions and whole games on every reference config, then writes the results as a baseline or
+// compares them with one. exits with 1 if a result is worse than its baseline by more than the threshold (20%,
+// timings of one machine are only comparable with baselines of the same machine).
+// the generated configs are written under bench_configs/, the loaders log into bench_log.txt
+
+#define MAX_RESULTS 64
+#define BENCH_REPEATS 5 // every timing is the best of this many runs, the least disturbed by the rest of the machine
+#define BENCH_TRIES 20  // layouts tried for a generated config before giving up on reaching the flag
+
+typedef struct
+{
+    const char *name;
+    const char *dir; // NULL for the shipped files in the current directory
+    int floors;
+    int width;
+    int length;
+    long stairs; // candidate lines written, the loaders drop the invalid ones
+    long poles;
+    long walls;
+    int junk;   // percent of lines that are malformed or out of bounds
+    long games; // the same games every run, a fifth of them with --quick
+} BenchConfig;
+
+// a big sparse maze, and a default sized one buried in overlapping, packed and broken lines
+const BenchConfig benchConfigs[] = {
+    {"shipped", NULL, .games = 500},
+    {"large", "bench_configs/large", 7, 40, 200, 6000, 3000, 6000, 0, 5},
+    {"adversarial", "bench_configs/adversarial", 3, 10, 25, 5000, 5000, 400, 30, 5000},
+};
+
+typedef struct
+{
+    char config[32];
+    char bench[32];
+    char unit[16]; // "us" and "ns/op" are better lower, "games/s" higher
+    double value;
+} BenchResult;
+
+typedef struct
+{
+    BenchResult results[MAX_RESULTS];
+    int count;
+} BenchResults;
+
+typedef struct
+{
+    long queries;       // isFlagReachable calls per run
+    long calls;    // calls per run of the other functions
+    int gameShare; // play games / gameShare of every config's games
+    int repeats;
+} BenchSizes;
+
+volatile long benchSink = 0; // keeps the timed loops from being optimized away
+
+void addResult(BenchResults *r, const char *config, const char *bench, const char *unit, double value)
+{
+    if (r->count == MAX_RESULTS)
+    {
+        printf("\nError: More than %d benchmark results.\n", MAX_RESULTS);
+        exit(1);
+    }
+    BenchResult *result = &r->results[r->count++];
+    snprintf(result->config, sizeof(result->config), "%s", config);
+    snprintf(result->bench, sizeof(result->bench), "%s", bench);
+    snprintf(result->unit, sizeof(result->unit), "%s", unit);
+    result->value = value;
+    printf("  %-12s %-26s %14.2f %s\n", config, bench, value, unit);
+}
+
+double fastest(const double *times, int count)
+{
+    double best = times[0];
+    for (int i = 1; i < count; i++)
+    {
+        best = times[i] < best ? times[i] : best;
+    }
+    return best;
+}
+
+// ----------------------------------------CONFIGS---------------------------------------
+
+void changeDirectory(const char *path)
+{
+#ifdef _WIN32
+    int failed = _chdir(path);
+#else
+    int failed = chdir(path);
+#endif
+    if (failed)
+    {
+        printf("\nError: Could not enter %s\n", path);
+        exit(1);
+    }
+}
+
+FILE *openConfigFile(const char *name)
+{
+    FILE *file = fopen(name, "w");
+    if (!file)
+    {
+        printf("\nError: Could not write %s\n", name);
+        exit(1);
+    }
+    return file;
+}
+
+// a line the loaders must drop: cut short, out of bounds or not numbers. false if this line should be a real one
+bool writeJunkLine(Rng *rng, const BenchConfig *c, FILE *file)
+{
+    if ((int)rngBelow(rng, 100) >= c->junk)
+    {
+        return false;
+    }
+    switch (rngBelow(rng, 3))
+    {
+    case 0:
+        fprintf(file, "[%d, %d,\n", (int)rngBelow(rng, c->floors), (int)rngBelow(rng, c->width));
+        break;
+    case 1:
+        fprintf(file, "[%d, -1, %d, %d, %d, %d]\n", c->floors, c->length, c->width, (int)rngBelow(rng, 100), -c->length);
+        break;
+    default:
+        fprintf(file, "[stairs, poles, walls]\n");
+        break;
+    }
+    return true;
+}
+
+// write the text files of a generated config into the current directory, another stream gives another layout
+void writeBenchConfig(const BenchConfig *c, unsigned int seed, uint64_t stream)
+{
+    Rng rng;
+    rngInit(&rng, seed, stream);
+
+    FILE *file = openConfigFile("maze.txt"); // no areas, the default footprint
+    fprintf(file, "[%d, %d, %d]\n", c->floors, c->width, c->length);
+    fclose(file);
+    file = openConfigFile("flag.txt"); // inside the default footprint of every floor
+    fprintf(file, "[%d, 7, 12]\n", c->floors - 1);
+    fclose(file);
+    file = openConfigFile("seed.txt");
+    fprintf(file, "%u\n", seed);
+    fclose(file);
+
+    file = openConfigFile("stairs.txt");
+    for (long i = 0; i < c->stairs; i++)
+    {
+        if (!writeJunkLine(&rng, c, file))
+        {
+            int f = (int)rngBelow(&rng, c->floors - 1);
+            fprintf(file, "[%d, %d, %d, %d, %d, %d]\n", f, (int)rngBelow(&rng, c->width), (int)rngBelow(&rng, c->length),
+                    f + 1, (int)rngBelow(&rng, c->width), (int)rngBelow(&rng, c->length));
+        }
+    }
+    fclose(file);
+
+    file = openConfigFile("poles.txt");
+    for (long i = 0; i < c->poles; i++)
+    {
+        if (!writeJunkLine(&rng, c, file))
+        {
+            int f = (int)rngBelow(&rng, c->floors - 1);
+            fprintf(file, "[%d, %d, %d, %d]\n", f, f + 1 + (int)rngBelow(&rng, c->floors - 1 - f),
+                    (int)rngBelow(&rng, c->width), (int)rngBelow(&rng, c->length));
+        }
+    }
+    fclose(file);
+
+    file = openConfigFile("walls.txt");
+    for (long i = 0; i < c->walls; i++)
+    {
+        if (!writeJunkLine(&rng, c, file))
+        {
+            int f = (int)rngBelow(&rng, c->floors), w = (int)rngBelow(&rng, c->width), l = (int)rngBelow(&rng, c->length);
+            int size = 1 + (int)rngBelow(&rng, 6);
+            if (i % 2)
+            {
+                fprintf(file, "[%d, %d, %d, %d, %d]\n", f, w, l, w, l + size < c->length ? l + size : c->length - 1);
+            }
+            else
+            {
+                fprintf(file, "[%d, %d, %d, %d, %d]\n", f, w, l, w + size < c->width ? w + size : c->width - 1, l);
+            }
+        }
+    }
+    fclose(file);
+}
+
+// build the maze of the config in the current directory. a generated config is written again with other
+// layouts until every player can reach the flag, as the game refuses to start otherwise
+unsigned int buildBenchMaze(const BenchConfig *c, Maze *m)
+{
+    for (int stream = 0; stream < BENCH_TRIES; stream++)
+    {
+        if (c->dir)
+        {
+            writeBenchConfig(c, 1, (uint64_t)stream);
+        }
+        unsigned int seed = loadSeed();
+        *m = (Maze){0};
+        intializeMaze(m, seed);
+        buildStepTable(m);
+        if (isFlagReachableFromStarts(m, seed))
+        {
+            return seed;
+        }
+        freeMaze(m);
+        if (!c->dir)
+        {
+            break;
+        }
+    }
+    printf("\nError: The flag of config %s can not be reached from the starting area.\n", c->name);
+    exit(1);
+}
+
+// ----------------------------------------MICRO BENCHMARKS---------------------------------------
+
+// the steps of buildMaze with the loaders and the movement points timed one by one, in seconds
+void timeMazeBuild(unsigned int seed, double seconds[4])
+{
+    Maze m = {0};
+    Rng rng;
+    rngInit(&rng, seed, RNG_MAZE_STREAM);
+    loadMazeSize(&m);
+    allocateMaze(&m);
+    setUpFloors(&m);
+    loadFlag(&m);
+    addFlagToMaze(&m);
+    initOccupancy(&m);
+
+    EntryList stairs, poles; // read as buildMaze reads them ahead of the walls, and read again below to time them
+    readStairsFile(&stairs, "stairs.txt");
+    readPolesFile(&poles, "poles.txt");
+    initBlockedSets(&m);
+    linkObjectEnds(&m, &stairs, &poles);
+    freeEntryList(&stairs);
+    freeEntryList(&poles);
+    double start = nowSeconds();
+    loadWalls(&m);
+    seconds[2] = nowSeconds() - start;
+    addWallstoMaze(&m);
+    freeBlockedSets(&m);
+
+    start = nowSeconds();
+    loadStairs(&m);
+    seconds[0] = nowSeconds() - start;
+    addStairsToMaze(&m);
+
+    start = nowSeconds();
+    loadPoles(&m);
+    seconds[1] = nowSeconds() - start;
+    addPolesToMaze(&m);
+    freeOccupancy(&m);
+
+    start = nowSeconds();
+    addMovementPointsToCells(&m, &rng);
+    seconds[3] = nowSeconds() - start;
+
+    bawanaSetUp(&m, &rng);
+    buildWalkableBits(&m);
+    buildRegions(&m);
+    freeMaze(&m);
+}
+
+void benchLoaders(BenchResults *r, const char *config, unsigned int seed, const BenchSizes *sizes)
+{
+    const char *names[4] = {"loadStairs", "loadPoles", "loadWalls", "addMovementPointsToCells"};
+    double times[4][BENCH_REPEATS] = {{0}};
+    for (int i = 0; i < sizes->repeats; i++)
+    {
+        double seconds[4];
+        timeMazeBuild(seed, seconds);
+        for (int b = 0; b < 4; b++)
+        {
+            times[b][i] = seconds[b];
+        }
+    }
+    for (int b = 0; b < 4; b++)
+    {
+        addResult(r, config, names[b], "us", 1e6 * fastest(times[b], sizes->repeats));
+    }
+}
+
+CellCord randomOpenCell(const Maze *m, Rng *rng)
+{
+    CellCord cell;
+    do
+    {
+        cell = cellFromIndex(m, (int)rngBelow(rng, m->noCells));
+    } while (isBlockedCell(m, cell));
+    return cell;
+}
+
+void benchFlagReachable(BenchResults *r, const char *config, Game *g, const BenchSizes *sizes)
+{
+    double times[BENCH_REPEATS] = {0};
+    CellCord *cells = (CellCord *)malloc(sizes->queries * sizeof(CellCord));
+    if (!cells)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (long i = 0; i < sizes->queries; i++)
+    {
+        cells[i] = randomOpenCell(g->maze, &g->rng);
+    }
+    for (int k = 0; k < sizes->repeats; k++)
+    {
+        long reachable = 0;
+        double start = nowSeconds();
+        for (long i = 0; i < sizes->queries; i++)
+        {
+            reachable += isFlagReachable(g, cells[i]);
+        }
+        times[k] = nowSeconds() - start;
+        benchSink += reachable;
+    }
+    addResult(r, config, "isFlagReachable", "ns/op", 1e9 * fastest(times, sizes->repeats) / sizes->queries);
+    free(cells);
+}
+
+void benchPlayerMoved(BenchResults *r, const char *config, Game *g, const BenchSizes *sizes)
+{
+    const Maze *m = g->maze;
+    double times[BENCH_REPEATS] = {0};
+    Move *moves = (Move *)malloc(sizes->calls * sizeof(Move));
+    if (!moves)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (long i = 0; i < sizes->calls; i++)
+    {
+        moves[i] = (Move){0, (int)rngBelow(&g->rng, MAX_MOVE_STEPS) + 1, (Direction)rngBelow(&g->rng, 4),
+                          randomOpenCell(m, &g->rng), 0, 1};
+    }
+    for (int k = 0; k < sizes->repeats; k++)
+    {
+        long moved = 0;
+        double start = nowSeconds();
+        for (long i = 0; i < sizes->calls; i++)
+        {
+            Move move = moves[i];
+            g->winner = NO_WINNER;
+            moved += isPlayerMoved(g, &move);
+        }
+        times[k] = nowSeconds() - start;
+        benchSink += moved;
+    }
+    addResult(r, config, "isPlayerMoved", "ns/op", 1e9 * fastest(times, sizes->repeats) / sizes->calls);
+    free(moves);
+}
+
+// takeStair from either end and takePole from any floor it spans, of random stairs and poles
+void benchRides(BenchResults *r, const char *config, Game *g, const BenchSizes *sizes)
+{
+    const Maze *m = g->maze;
+    double stairTimes[BENCH_REPEATS] = {0}, poleTimes[BENCH_REPEATS] = {0};
+    int *index = (int *)malloc(sizes->calls * sizeof(int));
+    CellCord *cells = (CellCord *)malloc(sizes->calls * sizeof(CellCord));
+    if (!index || !cells)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    for (int ride = 0; ride < 2; ride++)
+    {
+        int count = ride == 0 ? m->no_Stairs : m->no_Poles;
+        if (count == 0)
+        {
+            continue;
+        }
+        for (long i = 0; i < sizes->calls; i++)
+        {
+            index[i] = (int)rngBelow(&g->rng, count);
+            if (ride == 0)
+            {
+                const struct Stair *s = &m->stairs[index[i]];
+                cells[i] = rngBelow(&g->rng, 2) ? (CellCord){s->startFloor, s->startBlockWidth, s->startBlockLength}
+                                                : (CellCord){s->endFloor, s->endBlockWidth, s->endBlockLength};
+            }
+            else
+            {
+                const struct Pole *p = &m->poles[index[i]];
+                cells[i] = (CellCord){p->startFloor + (int)rngBelow(&g->rng, p->endFloor - p->startFloor + 1), p->widthCell, p->lengthCell};
+            }
+        }
+        for (int k = 0; k < sizes->repeats; k++)
+        {
+            long taken = 0;
+            double start = nowSeconds();
+            for (long i = 0; i < sizes->calls; i++)
+            {
+                CellCord cell = cells[i];
+                taken += ride == 0 ? takeStair(g, &cell, index[i]) : takePole(m, &cell, index[i]);
+            }
+            (ride == 0 ? stairTimes : poleTimes)[k] = nowSeconds() - start;
+            benchSink += taken;
+        }
+    }
+    if (m->no_Stairs)
+    {
+        addResult(r, config, "takeStair", "ns/op", 1e9 * fastest(stairTimes, sizes->repeats) / sizes->calls);
+    }
+    if (m->no_Poles)
+    {
+        addResult(r, config, "takePole", "ns/op", 1e9 * fastest(poleTimes, sizes->repeats) / sizes->calls);
+    }
+    free(index);
+    free(cells);
+}
+
+void benchMovementPoints(BenchResults *r, const char *config, Game *g, const BenchSizes *sizes)
+{
+    double times[BENCH_REPEATS] = {0};
+    CellCord *cells = (CellCord *)malloc(sizes->calls * sizeof(CellCord));
+    if (!cells)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (long i = 0; i < sizes->calls; i++)
+    {
+        cells[i] = randomOpenCell(g->maze, &g->rng);
+    }
+    for (int k = 0; k < sizes->repeats; k++)
+    {
+        Move move = {'A', 0, NORTH, {0, 0, 0}, 0, 1};
+        double start = nowSeconds();
+        for (long i = 0; i < sizes->calls; i++)
+        {
+            calcMovementPoints(g->maze, cells[i], &move);
+            move.mpMultiplyer = 1;
+        }
+        times[k] = nowSeconds() - start;
+        benchSink += move.movementPoints;
+    }
+    addResult(r, config, "calcMovementPoints", "ns/op", 1e9 * fastest(times, sizes->repeats) / sizes->calls);
+    free(cells);
+}
+
+// ----------------------------------------GAMES---------------------------------------
+
+// the config's first games of a batch, silent on one thread
+void benchGames(BenchResults *r, const BenchConfig *c, const Maze *m, unsigned int seed, const BenchSizes *sizes)
+{
+    long games = c->games / sizes->gameShare > 0 ? c->games / sizes->gameShare : 1;
+    double start = nowSeconds();
+    runBatch(m, seed, games, 1, NULL, NULL);
+    addResult(r, c->name, "games", "games/s", games / (nowSeconds() - start));
+}
+
+void runConfig(BenchResults *r, const BenchConfig *c, const BenchSizes *sizes)
+{
+    if (c->dir)
+    {
+        makeDirectory("bench_configs");
+        makeDirectory(c->dir);
+        changeDirectory(c->dir);
+    }
+    Maze maze;
+    unsigned int seed = buildBenchMaze(c, &maze);
+    printf("\n%s: %d x %d x %d maze, %d stairs, %d poles, %d walls\n", c->name, maze.floors, maze.width, maze.length,
+           maze.no_Stairs, maze.no_Poles, maze.no_Walls);
+
+    benchLoaders(r, c->name, seed, sizes);
+    Game game;
+    initGame(&game, &maze, seed, 0);
+    changeStairDirection(&game); // a mix of UP, DOWN and BI_DIR stairs
+    benchFlagReachable(r, c->name, &game, sizes);
+    benchPlayerMoved(r, c->name, &game, sizes);
+    benchRides(r, c->name, &game, sizes);
+    benchMovementPoints(r, c->name, &game, sizes);
+    freeGame(&game);
+    benchGames(r, c, &maze, seed, sizes);
+    freeMaze(&maze);
+
+    if (c->dir)
+    {
+        changeDirectory("../..");
+    }
+}
+
+// ----------------------------------------BASELINES---------------------------------------
+// one JSON object per line: {"config": "shipped", "bench": "isPlayerMoved", "unit": "ns/op", "value": 12.5}
+
+void saveBaseline(const BenchResults *r, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        printf("\nError: Could not write %s\n", path);
+        exit(1);
+    }
+    for (int i = 0; i < r->count; i++)
+    {
+        fprintf(file, "{\"config\": \"%s\", \"bench\": \"%s\", \"unit\": \"%s\", \"value\": %.6g}\n",
+                r->results[i].config, r->results[i].bench, r->results[i].unit, r->results[i].value);
+    }
+    fclose(file);
+    printf("\nBaseline written to %s\n", path);
+}
+
+void loadBaseline(BenchResults *r, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        printf("\nError: Could not open %s\n", path);
+        exit(1);
+    }
+    char line[256];
+    r->count = 0;
+    while (r->count < MAX_RESULTS && fgets(line, sizeof(line), file))
+    {
+        BenchResult *b = &r->results[r->count];
+        if (sscanf(line, " {\"config\": \"%31[^\"]\", \"bench\": \"%31[^\"]\", \"unit\": \"%15[^\"]\", \"value\": %lf}",
+                   b->config, b->bench, b->unit, &b->value) == 4)
+        {
+            r->count++;
+        }
+    }
+    fclose(file);
+}
+
+// print every result against its baseline, returns how many got worse by more than threshold percent
+int compareBaseline(const BenchResults *now, const BenchResults *base, double threshold)
+{
+    int regressions = 0;
+    printf("\nAgainst the baseline, worse by more than %.0f%% is a regression:\n", threshold);
+    printf("  %-12s %-26s %14s %14s %9s\n", "config", "bench", "now", "baseline", "worse by");
+    for (int i = 0; i < now->count; i++)
+    {
+        const BenchResult *n = &now->results[i];
+        const BenchResult *b = NULL;
+        for (int j = 0; j < base->count && !b; j++)
+        {
+            if (strcmp(base->results[j].config, n->config) == 0 && strcmp(base->results[j].bench, n->bench) == 0 &&
+                strcmp(base->results[j].unit, n->unit) == 0)
+            {
+                b = &base->results[j];
+            }
+        }
+        if (!b || b->value <= 0)
+        {
+            printf("  %-12s %-26s %14.2f %14s\n", n->config, n->bench, n->value, "none");
+            continue;
+        }
+        bool higherIsBetter = strcmp(n->unit, "games/s") == 0;
+        double worse = 100.0 * (higherIsBetter ? b->value - n->value : n->value - b->value) / b->value;
+        bool regressed = worse > threshold;
+        regressions += regressed;
+        printf("  %-12s %-26s %14.2f %14.2f %+8.1f%%%s\n", n->config, n->bench, n->value, b->value, worse, regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+// ---------------------------------------MAIN---------------------------------------
+int main(int argc, char *argv[])
+{
+    const char *configName = NULL;
+    const char *savePath = NULL;
+    const char *baselinePath = NULL;
+    double threshold = 20;
+    BenchSizes sizes = {2000, 1000000, 1, BENCH_REPEATS};
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            sizes = (BenchSizes){200, 100000, 5, 3};
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--config") == 0)
+        {
+            configName = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--save-baseline") == 0)
+        {
+            savePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--baseline") == 0)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--threshold") == 0)
+        {
+            threshold = atof(argv[++i]);
+        }
+        else
+        {
+            printf("\nUsage: %s [--quick] [--config <shipped|large|adversarial>] [--save-baseline <file>] [--baseline <file>] [--threshold <percent>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // the loaders log every line they drop, the adversarial config has tens of thousands
+    freopen("bench_log.txt", "w", stderr);
+    setvbuf(stderr, NULL, _IOFBF, 1 << 16);
+
+    static BenchResults results, baseline;
+    bool found = false;
+    printf("\nBenchmarks, every timing the best of %d runs:\n", sizes.repeats);
+    for (int c = 0; c < (int)(sizeof(benchConfigs) / sizeof(benchConfigs[0])); c++)
+    {
+        if (!configName || strcmp(configName, benchConfigs[c].name) == 0)
+        {
+            runConfig(&results, &benchConfigs[c], &sizes);
+            found = true;
+        }
+    }
+    if (!found)
+    {
+        printf("\nError: There is no config named %s.\n", configName);
+        return 1;
+    }
+
+    if (savePath)
+    {
+        saveBaseline(&results, savePath);
+    }
+    if (baselinePath)
+    {
+        loadBaseline(&baseline, baselinePath);
+        int regressions = compareBaseline(&results, &baseline, threshold);
+        printf("\n%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
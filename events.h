@@ -0,0 +1,165 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "helpers.h"
+
+// ----------------------------------------TEXT NARRATION---------------------------------------
+// a sink that tells every event as the lines of the narrated game, context is the FILE to write to
+
+void writeMoveText(FILE *out, const GameEvent *e, const char *name, char *cord)
+{
+    if (e->rolled && e->dir == NO_CHANGE)
+    {
+        fprintf(out, "%s rolls and %d on the movement dice and %s on the direction dice. %s's directions stays same and moves %d cells %s and is now at %s.\n",
+                name, e->dice, stringDirections[e->dir], name, e->steps, stringDirections[e->facing], cordToString(e->to, cord));
+    }
+    else if (e->rolled)
+    {
+        fprintf(out, "%s rolls and %d on the movement dice and %s on the direction dice, changes direction to %s and moves %d cells and is now at %s.\n",
+                name, e->dice, stringDirections[e->dir], stringDirections[e->dir], e->steps, cordToString(e->to, cord));
+    }
+    else
+    {
+        fprintf(out, "%s rolls and %d on the movement dice and moves %s by %d cells and is now at %s.\n",
+                name, e->dice, stringDirections[e->dir], e->steps, cordToString(e->to, cord));
+    }
+}
+
+void writeBlockedText(FILE *out, const GameEvent *e, const char *name, char *cord)
+{
+    if (e->rolled && e->dir == NO_CHANGE)
+    {
+        fprintf(out, "%s rolls and %d on the movement dice and %s on the direction dice, direction remains %s and cannot move. Player remains at %s.\n",
+                name, e->dice, stringDirections[e->dir], stringDirections[e->facing], cordToString(e->to, cord));
+    }
+    else if (e->rolled)
+    {
+        fprintf(out, "%s rolls and %d on the movement dice and %s on the direction dice, direction changed to %s but cannot move. Player remains at %s.\n",
+                name, e->dice, stringDirections[e->dir], stringDirections[e->dir], cordToString(e->to, cord));
+    }
+    else
+    {
+        fprintf(out, "%s rolls and %d on the movement dice and cannot move in the %s. Player remains at %s.\n",
+                name, e->dice, stringDirections[e->dir], cordToString(e->to, cord));
+    }
+}
+
+void writeBawanaText(FILE *out, const GameEvent *e, const char *name)
+{
+    switch (e->value)
+    {
+    case POISONED_CELL:
+        fprintf(out, "%s eats from Bawana and have a bad case of food poisoning. Will need three rounds to recover.\n", name);
+        break;
+    case DISORIENTED_CELL:
+        fprintf(out, "%s eats from Bawana and is disoriented and is placed at the entrance of Bawana with 50 movement points.\n", name);
+        break;
+    case TRIGGERED_CELL:
+        fprintf(out, "%s eats from Bawana and is triggered due to bad quality of food. %s is placed at the entrance of Bawana with 50 movement points.\n", name, name);
+        break;
+    case HAPPY_CELL:
+        fprintf(out, "%s eats from Bawana and is happy. %s is placed at the entrance of Bawana with 200 movement points.\n", name, name);
+        break;
+    case RANDOM_CELL:
+        fprintf(out, "%s eats from Bawana and earns %d movement points and is placed at the entrance of Bawana.\n", name, e->mp);
+        break;
+    }
+}
+
+void writeEventText(void *context, const GameEvent *e)
+{
+    FILE *out = (FILE *)context;
+    char cord[CORD_STR_SIZE], other[CORD_STR_SIZE], name[NAME_STR_SIZE], otherName[NAME_STR_SIZE];
+    playerName(e->player, name);
+    playerName(e->other, otherName);
+    switch ((EventKind)e->kind)
+    {
+    case EVENT_ROUND:
+        fprintf(out, "\n \tRound %d \n ===================== \n", e->value);
+        break;
+    case EVENT_TURN:
+        fprintf(out, "\n----%s's turn:----\n", name);
+        break;
+    case EVENT_STAIRS_CHANGED:
+        fprintf(out, "\n \\\\---Five rounds has passed. The direction of the stairs change randomly.---\\\\ \n");
+        break;
+    case EVENT_CUT_OFF:
+        fprintf(out, "\n \\---%s can not reach the flag with the current stair directions.---\\ \n", name);
+        break;
+    case EVENT_STAY_IN_START:
+        fprintf(out, "%s is at the starting area and rolls %d on the movement dice cannot enter the maze.\n", name, e->dice);
+        break;
+    case EVENT_ENTER_MAZE:
+        fprintf(out, "%s is at the starting area and rolls 6 on the movement dice and is placed on his entry cell of the maze.\n", name);
+        break;
+    case EVENT_POISON_WAIT:
+        fprintf(out, "%s is still food poisoned and misses the turn.\n", name);
+        break;
+    case EVENT_POISON_OVER:
+        fprintf(out, "%s is now fit to proceed from the food poisoning episode and now placed on a %s cell and the effects take place.\n",
+                name, stringBawanaEffects[e->value]);
+        break;
+    case EVENT_DISORIENTED_ROLL:
+        fprintf(out, "%s rolls and %d on the movement dice and is disoriented and move in the %s.\n", name, e->dice, stringDirections[e->dir]);
+        break;
+    case EVENT_DISORIENTED_OVER:
+        fprintf(out, "%s has recovered from disorientation.\n", name);
+        break;
+    case EVENT_TRIGGERED_ROLL:
+        fprintf(out, "%s is triggered and rolls and %d on the movement dice and move in the %s and moving %d cells.\n",
+                name, e->dice, stringDirections[e->dir], e->steps);
+        break;
+    case EVENT_TRIGGERED_OVER:
+        fprintf(out, "%s has recovered from triggered status.\n", name);
+        break;
+    case EVENT_STAIR:
+        fprintf(out, "%s lands on %s which is a stair cell. %s takes the stairs and now placed at %s.\n",
+                name, cordToString(e->from, other), name, cordToString(e->to, cord));
+        break;
+    case EVENT_POLE:
+        fprintf(out, "%s lands on %s which is a pole cell. %s slides down and now placed at %s.\n",
+                name, cordToString(e->from, other), name, cordToString(e->to, cord));
+        break;
+    case EVENT_MOVE:
+        writeMoveText(out, e, name, cord);
+        break;
+    case EVENT_BLOCKED:
+        writeBlockedText(out, e, name, cord);
+        break;
+    case EVENT_CAPTURE:
+        fprintf(out, "%s has been captured by %s at %s. Player %s has send to his starting location in starting area.\n",
+                name, otherName, cordToString(e->to, cord), name);
+        break;
+    case EVENT_DEPLETED:
+        fprintf(out, "%s movement points are depleted and requires replenishment. Transporting to Bawana.\n", name);
+        fprintf(out, "%s is place on a %s cell and effects take place.\n", name, stringBawanaEffects[e->value]);
+        break;
+    case EVENT_BAWANA:
+        writeBawanaText(out, e, name);
+        break;
+    case EVENT_BACK_TO_START:
+        fprintf(out, "%s is back to starting area. %s send to his starting location - %s and direction change to starting direction - %s. Movement points are not reset.\n",
+                name, name, cordToString(e->to, cord), stringDirections[e->dir]);
+        break;
+    case EVENT_MOVE_DONE:
+        fprintf(out, "%s moved %d cells that cost %d movement points and is left with %d and is moving in the %s.\n",
+                name, e->steps, e->value, e->mp, stringDirections[e->dir]);
+        break;
+    case EVENT_WIN:
+        fprintf(out, "\n\n------------------------------------- Game Over -------------------------------------\n\n");
+        fprintf(out, "%s has capture the flag at %s. The winner is %s.\n\n", name, cordToString(e->to, cord), name);
+        break;
+    case EVENT_GAME_END:
+        if (e->player != NO_WINNER)
+        {
+            fprintf(out, "%s won in round %d.\n", name, e->value);
+        }
+        else
+        {
+            fprintf(out, "unfinished after %d rounds.\n", e->value);
+        }
+        break;
+    }
+}
+
+#endif
@@ -0,0 +1,545 @@
+#ifndef GENERATE_H
+#define GENERATE_H
+
+#include "sim.h"
+
+// ----------------------------------------LAYOUT GENERATOR---------------------------------------
+// random layouts drawn straight against the loaders' rules, instead of random lines the loaders mostly throw away.
+// the flag is drawn first and a stair laid from every floor below it to the next, so the floors up to the flag are
+// joined before anything else goes in. walls are runs of active cells no other object holds, kept only if the
+// starts and BawanaEntry stay joined to the flag - the loader's own check, so no wall can close the way to it - and
+// stairs and poles are drawn on cells they may take. every layout is laid again by layMaze, the way the loaders lay
+// it, and its flag checked from every start cell, by cells and by whole moves, before it is written, a layout that
+// fails is drawn again
+
+#define GEN_WALLS_PER_FLOOR 4
+#define GEN_STAIRS_PER_FLOOR 3 // for every pair of floors
+#define GEN_POLES_PER_FLOOR 1
+#define GEN_MAX_WALL 6     // cells in a wall
+#define GEN_TRIES 32       // draws of an object before it is given up, or of a layout before the generator gives up
+#define GEN_PATH_SIZE 512
+#define GEN_MAX_FLAG_MOVES 4 // whole moves to the flag, a flag further off is mostly shut in behind bends
+
+#define RNG_LAYOUT_STREAM (UINT64_MAX - 2) // layout i is drawn from branch i of this stream
+
+typedef struct
+{
+    Maze work;          // the grid the objects are drawn on, with the loaders' occupancy index and blocked sets
+    EntryList lists[3]; // walls, stairs and poles drawn, as the entries of their files
+    CellCord flag;
+} LayoutDraft;
+
+void initLayoutDraft(LayoutDraft *d, const Maze *size)
+{
+    memset(d, 0, sizeof(*d));
+    copyMazeSize(&d->work, size);
+    allocateMaze(&d->work);
+    const int widths[3] = {5, 6, 4};
+    const int counts[3] = {GEN_WALLS_PER_FLOOR * size->floors, GEN_STAIRS_PER_FLOOR * size->floors, GEN_POLES_PER_FLOOR * size->floors};
+    for (int k = 0; k < 3; k++)
+    {
+        d->lists[k].width = widths[k];
+        d->lists[k].values = (int *)malloc(counts[k] * widths[k] * sizeof(int));
+        d->lists[k].lines = (int *)malloc(counts[k] * sizeof(int));
+        if (!d->lists[k].values || !d->lists[k].lines)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+}
+
+void freeLayoutDraft(LayoutDraft *d)
+{
+    for (int k = 0; k < 3; k++)
+    {
+        freeEntryList(&d->lists[k]);
+    }
+    freeMaze(&d->work);
+}
+
+void addDraftEntry(EntryList *e, const int *values)
+{
+    memcpy(e->values + e->count * e->width, values, e->width * sizeof(int));
+    e->count++;
+    e->lines[e->count - 1] = e->count;
+}
+
+// a cell in one of the floor's areas, so a floor that is mostly empty cells costs no more draws than a full one
+CellCord drawAreaCell(const Maze *m, Rng *rng, int floor)
+{
+    int count = 0;
+    for (int i = 0; i < m->no_Areas; i++)
+    {
+        count += m->areas[i].floor == floor;
+    }
+    int pick = count ? (int)rngBelow(rng, count) : 0;
+    for (int i = 0; i < m->no_Areas; i++)
+    {
+        struct FloorArea a = m->areas[i];
+        if (a.floor == floor && pick-- == 0)
+        {
+            return (CellCord){floor, a.startBlockWidth + (int)rngBelow(rng, a.endBlockWidth - a.startBlockWidth + 1),
+                              a.startBlockLength + (int)rngBelow(rng, a.endBlockLength - a.startBlockLength + 1)};
+        }
+    }
+    return (CellCord){floor, (int)rngBelow(rng, m->width), (int)rngBelow(rng, m->length)};
+}
+
+// a cell of the floor a stair or pole end may take: walkable, not special and held by no object
+bool drawFreeCell(const Maze *m, Rng *rng, int floor, CellCord *cell)
+{
+    for (int i = 0; i < GEN_TRIES; i++)
+    {
+        *cell = drawAreaCell(m, rng, floor);
+        if (isValidCell(m, *cell) && isSpanFree(m, *cell, (CellCord){0, 0, 0}, 1, STAIR_OWNER, 0, false))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// a stair from the floor to the one above
+bool drawStair(LayoutDraft *d, Rng *rng, int floor)
+{
+    Maze *m = &d->work;
+    CellCord start, end;
+    for (int i = 0; i < GEN_TRIES; i++)
+    {
+        if (!drawFreeCell(m, rng, floor, &start) || !drawFreeCell(m, rng, floor + 1, &end))
+        {
+            return false;
+        }
+        if (start.width != end.width || start.length != end.length)
+        {
+            CellCord none = {0, 0, 0};
+            claimSpan(m, start, none, 1, STAIR_OWNER, d->lists[1].count + 1);
+            claimSpan(m, end, none, 1, STAIR_OWNER, d->lists[1].count + 1);
+            int v[6] = {start.floor, start.width, start.length, end.floor, end.width, end.length};
+            addDraftEntry(&d->lists[1], v);
+            return true;
+        }
+    }
+    return false;
+}
+
+// a run of at least two active cells no object but a wall holds, that leaves the flag joined to the starts
+bool drawWall(LayoutDraft *d, Rng *rng)
+{
+    Maze *m = &d->work;
+    for (int i = 0; i < GEN_TRIES; i++)
+    {
+        CellCord start = drawAreaCell(m, rng, (int)rngBelow(rng, m->floors));
+        bool horizontal = rngBelow(rng, 2);
+        CellCord step = horizontal ? (CellCord){0, 0, 1} : (CellCord){0, 1, 0};
+        int want = 2 + (int)rngBelow(rng, GEN_MAX_WALL - 1), count = 0;
+        CellCord cell = start;
+        while (count < want && isValidCordinates(m, cell) && cellTypeOf(m->cells[cellIndex(m, cell)]) == ACTIVE_CELL &&
+               isSpanFree(m, cell, step, 1, WALL_OWNER, 0, false))
+        {
+            count++;
+            cell = (CellCord){cell.floor, cell.width + step.width, cell.length + step.length};
+        }
+        if (count < 2)
+        {
+            continue;
+        }
+        CellCord end = {start.floor, start.width + (count - 1) * step.width, start.length + (count - 1) * step.length};
+        struct Wall wall = {start.floor, start.width, start.length, end.width, end.length};
+        if (!keepsFlagJoined(m, wall, 0, false))
+        {
+            continue;
+        }
+        claimSpan(m, start, step, count, WALL_OWNER, d->lists[0].count + 1);
+        for (int c = 0; c < count; c++)
+        { // later walls and the stairs and poles keep off it, the loaders would let a wall cross it
+            CellCord at = {start.floor, start.width + c * step.width, start.length + c * step.length};
+            m->cells[cellIndex(m, at)] = packCell(WALL_CELL, -1);
+        }
+        int v[5] = {wall.floor, wall.startBlockWidth, wall.startBlockLength, wall.endBlockWidth, wall.endBlockLength};
+        addDraftEntry(&d->lists[0], v);
+        return true;
+    }
+    return false;
+}
+
+// a pole from a floor up to any floor above it, over cells no object holds
+bool drawPole(LayoutDraft *d, Rng *rng)
+{
+    Maze *m = &d->work;
+    for (int i = 0; i < GEN_TRIES && m->floors > 1; i++)
+    {
+        int bottom = (int)rngBelow(rng, m->floors - 1);
+        int top = bottom + 1 + (int)rngBelow(rng, m->floors - 1 - bottom);
+        CellCord start = drawAreaCell(m, rng, bottom);
+        CellCord end = {top, start.width, start.length};
+        CellCord up = {1, 0, 0};
+        if (isValidCell(m, start) && isValidCell(m, end) && isSpanFree(m, start, up, top - bottom + 1, POLE_OWNER, 0, false))
+        {
+            claimSpan(m, start, up, top - bottom + 1, POLE_OWNER, d->lists[2].count + 1);
+            int v[4] = {bottom, top, start.width, start.length};
+            addDraftEntry(&d->lists[2], v);
+            return true;
+        }
+    }
+    return false;
+}
+
+// draw one layout, false if an object the layout needs could not be placed
+bool draftLayout(LayoutDraft *d, Rng *rng)
+{
+    Maze *m = &d->work;
+    for (int k = 0; k < 3; k++)
+    {
+        d->lists[k].count = 0;
+    }
+    free(m->bawanaCells);
+    setUpFloors(m);
+
+    int tries = 0;
+    do
+    {
+        d->flag = drawAreaCell(m, rng, (int)rngBelow(rng, m->floors));
+    } while (!isVacantCell(m, d->flag) && ++tries < GEN_TRIES * GEN_TRIES);
+    if (!isVacantCell(m, d->flag))
+    {
+        return false;
+    }
+    m->Flag = d->flag;
+    addFlagToMaze(m);
+    initOccupancy(m);
+    initBlockedSets(m);
+
+    bool drawn = true;
+    for (int f = 0; f < d->flag.floor && drawn; f++)
+    { // the way up to the flag, before any wall
+        drawn = drawStair(d, rng, f);
+    }
+    linkObjectEnds(m, &d->lists[1], NULL);
+    for (int i = 0; i < GEN_WALLS_PER_FLOOR * m->floors && drawn; i++)
+    {
+        drawWall(d, rng);
+    }
+    freeBlockedSets(m);
+    for (int i = 0; i < GEN_STAIRS_PER_FLOOR * (m->floors - 1) && d->lists[1].count < GEN_STAIRS_PER_FLOOR * (m->floors - 1) && drawn; i++)
+    {
+        drawStair(d, rng, (int)rngBelow(rng, m->floors - 1));
+    }
+    for (int i = 0; i < GEN_POLES_PER_FLOOR * m->floors && drawn; i++)
+    {
+        drawPole(d, rng);
+    }
+    freeOccupancy(m);
+    return drawn && d->lists[0].count > 0 && d->lists[1].count > 0 && d->lists[2].count > 0;
+}
+
+// the cells whole moves of 1 to 6 steps from the cell end on with every stair the same way. a move of n steps is the
+// first n steps of the move of 6, so one walk gives them all. ends[n - 1] is -1 where the move is blocked or ends in
+// a starting area, which sends the player back to their start. true if the walk went over a stair, the other ways
+// of the stairs may then end elsewhere
+bool draftMoveEnds(Game *g, int cell, Direction dir, int ends[6])
+{
+    const Maze *m = g->maze;
+    Move move = {.steps = 6, .dir = dir, .currentCell = cellFromIndex(m, cell), .mpMultiplyer = 1};
+    GameEvent rides[MAX_MOVE_STEPS];
+    int count = 0;
+    bool stair = false;
+    for (int n = 0; n < 6; n++)
+    {
+        ends[n] = -1;
+    }
+    for (int n = 0; n < 6 && g->winner == NO_WINNER && isNextStepPossible(m, move.currentCell, dir); n++)
+    {
+        stair |= cellTypeOf(getNextCell(m, getNextCellCoord(move.currentCell, dir))) == STAIR_CELL;
+        movePlayer(g, &move, rides, &count);
+        ends[n] = isStartingAreaCell(m, move.currentCell) ? -1 : cellIndex(m, move.currentCell);
+    }
+    return stair;
+}
+
+// the fewest whole moves of the movement dice that capture the flag from the cells the players enter the maze on,
+// or from BawanaEntry, where a player running out of movement points always ends up, -1 if none do. connected cells
+// are not enough, a player only turns on every 4th throw, so a pocket behind bends of single cells is next to never
+// entered, and the further the flag is the more such bends the way to it takes
+int flagMoveDistance(const Maze *m, unsigned int seed)
+{
+    const StairDirection ways[3] = {BI_DIR, UP, DOWN};
+    Game game;
+    initGame(&game, m, seed, 0);
+    int *queue = (int *)malloc(m->noCells * sizeof(int));
+    int *moves = (int *)malloc(m->noCells * sizeof(int));
+    if (!queue || !moves)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int c = 0; c < m->noCells; c++)
+    {
+        moves[c] = -1;
+    }
+
+    int count = 0, ends[6];
+    for (int p = -1; p < m->no_Players; p++)
+    {
+        if (p >= 0)
+        {
+            draftMoveEnds(&game, cellIndex(m, m->startCells[p]), m->startDirs[p], ends);
+        }
+        int cell = p < 0 ? cellIndex(m, BawanaEntry) : ends[0];
+        if (cell >= 0 && moves[cell] < 0)
+        {
+            moves[cell] = 0;
+            queue[count++] = cell;
+        }
+    }
+
+    int distance = -1;
+    for (int head = 0; head < count && distance < 0; head++)
+    {
+        for (Direction d = NORTH; d <= WEST && distance < 0; d++)
+        {
+            bool stair = true;
+            for (int w = 0; w < 3 && stair && distance < 0; w++)
+            {
+                for (int i = 0; i < m->no_Stairs; i++)
+                {
+                    game.stairDirs[i] = ways[w];
+                }
+                stair = draftMoveEnds(&game, queue[head], d, ends);
+                distance = game.winner != NO_WINNER ? moves[queue[head]] + 1 : -1;
+                for (int n = 0; n < 6; n++)
+                {
+                    if (ends[n] >= 0 && moves[ends[n]] < 0)
+                    {
+                        moves[ends[n]] = moves[queue[head]] + 1;
+                        queue[count++] = ends[n];
+                    }
+                }
+            }
+        }
+    }
+    free(queue);
+    free(moves);
+    freeGame(&game);
+    return distance;
+}
+
+// lay the draft the way the loaders would into a maze of its own, true if every object of it is kept, every player
+// can reach the flag by cells, and whole moves reach it in at most GEN_MAX_FLAG_MOVES
+bool checkLayoutDraft(const LayoutDraft *d, unsigned int seed, Maze *m)
+{
+    *m = (Maze){0};
+    copyMazeSize(m, &d->work);
+    MazeLayout layout = {d->flag, &d->lists[0], &d->lists[1], &d->lists[2]};
+    if (!layMaze(m, seed, &layout) || m->no_Walls != d->lists[0].count || m->no_Stairs != d->lists[1].count ||
+        m->no_Poles != d->lists[2].count || !isFlagReachableFromStarts(m, seed))
+    {
+        return false;
+    }
+    int moves = flagMoveDistance(m, seed);
+    return moves >= 0 && moves <= GEN_MAX_FLAG_MOVES;
+}
+
+// ----------------------------------------LAYOUT OUTPUT---------------------------------------
+
+FILE *openLayoutFile(const char *dir, const char *name)
+{
+    char path[GEN_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        printf("\nError: Could not write %s\n", path);
+        exit(1);
+    }
+    return file;
+}
+
+void writeEntryList(const char *dir, const char *name, const EntryList *e)
+{
+    FILE *file = openLayoutFile(dir, name);
+    for (int i = 0; i < e->count; i++)
+    {
+        fputc('[', file);
+        for (int k = 0; k < e->width; k++)
+        {
+            fprintf(file, k ? ", %d" : "%d", e->values[i * e->width + k]);
+        }
+        fputs("]\n", file);
+    }
+    fclose(file);
+}
+
+// the text files of a layout into a directory of its own, maze.txt included as the layout only fits its size
+void writeLayoutText(const LayoutDraft *d, const char *dir)
+{
+    const Maze *m = &d->work;
+    makeDirectory(dir);
+    FILE *file = openLayoutFile(dir, "maze.txt");
+    fprintf(file, "[%d, %d, %d]\n", m->floors, m->width, m->length);
+    for (int i = 0; i < m->no_Areas; i++)
+    {
+        struct FloorArea a = m->areas[i];
+        fprintf(file, "[%d, %d, %d, %d, %d]\n", a.floor, a.startBlockWidth, a.startBlockLength, a.endBlockWidth, a.endBlockLength);
+    }
+    fclose(file);
+    file = openLayoutFile(dir, "flag.txt");
+    fprintf(file, "[%d, %d, %d]\n", d->flag.floor, d->flag.width, d->flag.length);
+    fclose(file);
+    writeEntryList(dir, "walls.txt", &d->lists[0]);
+    writeEntryList(dir, "stairs.txt", &d->lists[1]);
+    writeEntryList(dir, "poles.txt", &d->lists[2]);
+}
+
+// ----------------------------------------GENERATOR RUN---------------------------------------
+
+typedef struct
+{
+    const Maze *size;
+    unsigned int seed;
+    long first; // this worker draws layouts first, first + stride, ...
+    long stride;
+    long count;
+    const char *dir;  // NULL to only draw and check the layouts
+    bool snapshot;    // write each layout as a built maze snapshot instead of text files
+    CellCord *flags;  // [layout]
+    long redrawn;     // drafts that failed, drawn again
+    long objects[3];
+} GenerateWorker;
+
+void *generateWorkerRun(void *arg)
+{
+    GenerateWorker *worker = (GenerateWorker *)arg;
+    LayoutDraft draft;
+    initLayoutDraft(&draft, worker->size);
+    char path[GEN_PATH_SIZE];
+
+    for (long i = worker->first; i < worker->count; i += worker->stride)
+    {
+        Rng rng;
+        rngInit(&rng, worker->seed, RNG_LAYOUT_STREAM);
+        rngBranch(&rng, (uint64_t)i);
+        Maze m;
+        int tries = 0;
+        while (1)
+        {
+            bool drawn = draftLayout(&draft, &rng);
+            if (drawn && checkLayoutDraft(&draft, worker->seed, &m))
+            {
+                break;
+            }
+            if (drawn)
+            {
+                freeMaze(&m);
+            }
+            worker->redrawn++;
+            if (++tries == GEN_TRIES)
+            {
+                printf("\nError: No valid layout found for the maze size in %d drafts.\n", GEN_TRIES);
+                exit(1);
+            }
+        }
+
+        worker->flags[i] = draft.flag;
+        for (int k = 0; k < 3; k++)
+        {
+            worker->objects[k] += draft.lists[k].count;
+        }
+        if (worker->dir && worker->snapshot)
+        {
+            buildStepTable(&m);
+            snprintf(path, sizeof(path), "%s/%05ld.snl", worker->dir, i);
+            saveMazeSnapshot(&m, worker->seed, path);
+        }
+        else if (worker->dir)
+        {
+            snprintf(path, sizeof(path), "%s/%05ld", worker->dir, i);
+            writeLayoutText(&draft, path);
+        }
+        freeMaze(&m);
+    }
+    freeLayoutDraft(&draft);
+    return NULL;
+}
+
+// draw count valid layouts for the maze size of maze.txt on the given threads. with a directory every layout is
+// written into it, as a directory of text files with a sweep.txt listing them all, or as a maze snapshot
+void runGenerator(unsigned int seed, long count, int threads, const char *dir, bool snapshot)
+{
+    Maze size = {0};
+    loadMazeSize(&size);
+    GenerateWorker workers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    CellCord *flags = (CellCord *)malloc(count * sizeof(CellCord));
+    if (!flags)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    if (dir)
+    {
+        makeDirectory(dir);
+    }
+
+    double start = nowSeconds();
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t] = (GenerateWorker){.size = &size, .seed = seed, .first = t, .stride = threads, .count = count,
+                                      .dir = dir, .snapshot = snapshot, .flags = flags};
+    }
+    for (int t = 1; t < threads; t++)
+    {
+        if (pthread_create(&ids[t], NULL, generateWorkerRun, &workers[t]) != 0)
+        {
+            printf("\nError: Could not start generator thread.\n");
+            exit(1);
+        }
+    }
+    generateWorkerRun(&workers[0]);
+    long redrawn = 0, objects[3] = {0};
+    for (int t = 0; t < threads; t++)
+    {
+        if (t > 0)
+        {
+            pthread_join(ids[t], NULL);
+        }
+        redrawn += workers[t].redrawn;
+        for (int k = 0; k < 3; k++)
+        {
+            objects[k] += workers[t].objects[k];
+        }
+    }
+    double elapsed = nowSeconds() - start;
+
+    if (dir && !snapshot)
+    { // the layouts side by side in a sweep
+        char path[GEN_PATH_SIZE];
+        snprintf(path, sizeof(path), "%s/sweep.txt", dir);
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            printf("\nError: Could not write %s\n", path);
+            exit(1);
+        }
+        for (long i = 0; i < count; i++)
+        {
+            fprintf(file, "variant [%d, %d, %d] %s/%05ld/walls.txt %s/%05ld/stairs.txt %s/%05ld/poles.txt\n",
+                    flags[i].floor, flags[i].width, flags[i].length, dir, i, dir, i, dir, i);
+        }
+        fclose(file);
+    }
+
+    printf("\nGenerated %ld layouts of %d x %d x %d in %.3f s (%.0f layouts/sec) on %d threads\n", count, size.floors,
+           size.width, size.length, elapsed, elapsed > 0 ? count / elapsed : 0.0, threads);
+    printf("  objects per layout: %.1f walls, %.1f stairs, %.1f poles, %ld drafts drawn again\n", (double)objects[0] / count,
+           (double)objects[1] / count, (double)objects[2] / count, redrawn);
+    if (dir)
+    {
+        printf("  written to %s%s\n", dir, snapshot ? " as maze snapshots" : ", with sweep.txt listing them");
+    }
+    free(flags);
+    free(size.areas);
+}
+
+#endif
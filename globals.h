@@ -0,0 +1,18 @@
+#ifndef GLOBALS_H
+#define GLOBALS_H
+
+#include "types.h"
+
+// ----------------------------------------GLOBAL VARIABLES---------------------------------------
+// defined once in every program built from these headers, the game (main.c) and the benchmark (bench.c)
+
+// constants
+const CellCord BawanaEntry = {0, 9, 19};
+
+const CellCord specialCells[] = {BawanaEntry, {0, 6, 12}, {0, 5, 12}, {0, 9, 8}, {0, 9, 7}, {0, 9, 16}, {0, 9, 17}};
+
+const char *stringDirections[] = {"NORTH", "EAST", "SOUTH", "WEST", "EMPTY"};
+
+const char *stringBawanaEffects[] = {"POISONED", "DISORIENTED", "TRIGGERED", "HAPPY", "RANDOM"};
+
+#endif
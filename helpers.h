@@ -3,17 +3,46 @@
 
 #include "types.h"
 
+// ----------------------------------------PACKED CELLS---------------------------------------
+// a cell without an object has id -1
+Cell packCell(CellType type, int id) { return (Cell)(type | (id + 1) << CELL_TYPE_BITS); }
+
+// an active cell with a movement point effect
+Cell packEffectCell(MPEffectType effect, int value) { return (Cell)(ACTIVE_CELL | effect << CELL_TYPE_BITS | value << (CELL_TYPE_BITS + 2)); }
+
+CellType cellTypeOf(Cell c) { return (CellType)(c & CELL_TYPE_MASK); }
+
+// stair, pole or bawana id of the cell
+int cellIdOf(Cell c) { return (c >> CELL_TYPE_BITS) - 1; }
+
+// only active cells carry an effect, the same bits hold the id of other cells
+MPEffectType cellEffectOf(Cell c) { return cellTypeOf(c) == ACTIVE_CELL ? (MPEffectType)(c >> CELL_TYPE_BITS & 3) : MP_NONE; }
+
+int cellEffectValueOf(Cell c) { return cellTypeOf(c) == ACTIVE_CELL ? c >> (CELL_TYPE_BITS + 2) & 7 : 0; }
+
+// ----------------------------------------CELL INDEXING---------------------------------------
+// flat index of a cell into the grid and the precomputed tables
+int cellIndex(const Maze *m, CellCord c) { return (c.floor * m->width + c.width) * m->length + c.length; }
+
+CellCord cellFromIndex(const Maze *m, int index)
+{
+    return (CellCord){index / (m->width * m->length), index / m->length % m->width, index % m->length};
+}
+
+// offset of the packed row (f, w) in a [floor][width][rowWords] bitboard
+size_t rowOffset(const Maze *m, int f, int w) { return ((size_t)f * m->width + w) * m->rowWords; }
+
 // ----------------------------------------VALIDATION SUPPORT---------------------------------------
 
-bool isValidFloor(int floor) { return floor >= 0 && floor < FLOORS; }
+bool isValidFloor(const Maze *m, int floor) { return floor >= 0 && floor < m->floors; }
 
-bool isValidWidth(int width) { return width >= 0 && width < WIDTH; }
+bool isValidWidth(const Maze *m, int width) { return width >= 0 && width < m->width; }
 
-bool isValidLength(int length) { return length >= 0 && length < LENGTH; }
+bool isValidLength(const Maze *m, int length) { return length >= 0 && length < m->length; }
 
-bool isValidCordinates(CellCord cell)
+bool isValidCordinates(const Maze *m, CellCord cell)
 {
-    return isValidFloor(cell.floor) && isValidWidth(cell.width) && isValidLength(cell.length);
+    return isValidFloor(m, cell.floor) && isValidWidth(m, cell.width) && isValidLength(m, cell.length);
 }
 
 // check two location are the same
@@ -35,51 +64,52 @@ bool isSpecialCell(CellCord cell)
 }
 
 // check if cell is only a game cell and no object in it or is not a special cell(player start, player entry, bawana entry)
-bool isVacantCell(CellCord cell)
+bool isVacantCell(const Maze *m, CellCord cell)
 {
-    return isValidCordinates(cell) && maze[cell.floor][cell.width][cell.length].cellType == ACTIVE_CELL;
+    return isValidCordinates(m, cell) && cellTypeOf(m->cells[cellIndex(m, cell)]) == ACTIVE_CELL;
 }
 
 // check if cell is within booundires and vacant
-bool isValidCell(CellCord cell)
+bool isValidCell(const Maze *m, CellCord cell)
 {
-    return isValidCordinates(cell) && !isSpecialCell(cell) &&
-           (maze[cell.floor][cell.width][cell.length].cellType == ACTIVE_CELL || maze[cell.floor][cell.width][cell.length].cellType == STARTING_AREA_CELL);
+    return isValidCordinates(m, cell) && !isSpecialCell(cell) &&
+           (cellTypeOf(m->cells[cellIndex(m, cell)]) == ACTIVE_CELL || cellTypeOf(m->cells[cellIndex(m, cell)]) == STARTING_AREA_CELL);
 }
 
 // check for walls and boundries
-bool isBlockedCell(CellCord cell)
+bool isBlockedCell(const Maze *m, CellCord cell)
 {
-    return maze[cell.floor][cell.width][cell.length].cellType == WALL_CELL ||
-           maze[cell.floor][cell.width][cell.length].cellType == EMPTY_CELL;
+    CellType type = cellTypeOf(m->cells[cellIndex(m, cell)]);
+    return type == WALL_CELL || type == EMPTY_CELL;
 }
 
-bool isStartingAreaCell(CellCord cell) { return maze[cell.floor][cell.width][cell.length].cellType == STARTING_AREA_CELL; }
+// the cell a player at cell walks on from: Bawana is walled in, a player there is put back on BawanaEntry
+CellCord walkingCell(const Maze *m, CellCord cell) { return cellTypeOf(m->cells[cellIndex(m, cell)]) == BAWANA_CELL ? BawanaEntry : cell; }
+
+bool isStartingAreaCell(const Maze *m, CellCord cell) { return cellTypeOf(m->cells[cellIndex(m, cell)]) == STARTING_AREA_CELL; }
 
 // check if a stair is valid
-bool isValidStair(struct Stair stair, int line, bool logError)
+bool isValidStair(const Maze *m, struct Stair stair, int line, bool logError)
 {
     CellCord startCell = {stair.startFloor, stair.startBlockWidth, stair.startBlockLength};
     CellCord endCell = {stair.endFloor, stair.endBlockWidth, stair.endBlockLength};
 
-    if (!isValidCell(startCell))
+    if (!isValidCell(m, startCell))
     {
         if (logError)
         {
             fprintf(stderr, "Line %d of stairs.txt: Invalid start cell [%d,%d,%d].\n",
                     line, stair.startFloor, stair.startBlockWidth, stair.startBlockLength);
-            fflush(stderr);
         }
         return false;
     }
 
-    if (!isValidCell(endCell))
+    if (!isValidCell(m, endCell))
     {
         if (logError)
         {
             fprintf(stderr, "Line %d of stairs.txt: Invalid end cell [%d,%d,%d].\n",
                     line, stair.endFloor, stair.endBlockWidth, stair.endBlockLength);
-            fflush(stderr);
         }
         return false;
     }
@@ -90,7 +120,6 @@ bool isValidStair(struct Stair stair, int line, bool logError)
         {
             fprintf(stderr, "Line %d of stairs.txt: Stair must connect consecutive floors (got %d -> %d).\n",
                     line, startCell.floor, endCell.floor);
-            fflush(stderr);
         }
         return false;
     }
@@ -100,7 +129,6 @@ bool isValidStair(struct Stair stair, int line, bool logError)
         if (logError)
         {
             fprintf(stderr, "Line %d of stairs.txt: Stair cannot be vertical.\n", line);
-            fflush(stderr);
         }
         return false;
     }
@@ -109,29 +137,27 @@ bool isValidStair(struct Stair stair, int line, bool logError)
 }
 
 // check if pole is valid
-bool isValidPole(struct Pole pole, int line, bool logError)
+bool isValidPole(const Maze *m, struct Pole pole, int line, bool logError)
 {
     CellCord startCell = {pole.startFloor, pole.widthCell, pole.lengthCell};
     CellCord endCell = {pole.endFloor, pole.widthCell, pole.lengthCell};
 
-    if (!isValidCell(startCell))
+    if (!isValidCell(m, startCell))
     {
         if (logError)
         {
             fprintf(stderr, "Line %d of poles.txt: Invalid start cell [%d,%d,%d].\n",
                     line, pole.startFloor, pole.widthCell, pole.lengthCell);
-            fflush(stderr);
         }
         return false;
     }
 
-    if (!isValidCell(endCell))
+    if (!isValidCell(m, endCell))
     {
         if (logError)
         {
             fprintf(stderr, "Line %d of poles.txt: Invalid end cell [%d,%d,%d].\n",
                     line, pole.endFloor, pole.widthCell, pole.lengthCell);
-            fflush(stderr);
         }
         return false;
     }
@@ -142,7 +168,6 @@ bool isValidPole(struct Pole pole, int line, bool logError)
         {
             fprintf(stderr, "Line %d of poles.txt: Pole must start below and end above (got %d -> %d).\n",
                     line, startCell.floor, endCell.floor);
-            fflush(stderr);
         }
         return false;
     }
@@ -151,18 +176,17 @@ bool isValidPole(struct Pole pole, int line, bool logError)
 }
 
 // check if wall is valid
-bool isValidWall(struct Wall wall, int line, bool logError)
+bool isValidWall(const Maze *m, struct Wall wall, int line, bool logError)
 {
-    if (!isValidFloor(wall.floor) ||
-        !isValidWidth(wall.startBlockWidth) ||
-        !isValidWidth(wall.endBlockWidth) ||
-        !isValidLength(wall.startBlockLength) ||
-        !isValidLength(wall.endBlockLength))
+    if (!isValidFloor(m, wall.floor) ||
+        !isValidWidth(m, wall.startBlockWidth) ||
+        !isValidWidth(m, wall.endBlockWidth) ||
+        !isValidLength(m, wall.startBlockLength) ||
+        !isValidLength(m, wall.endBlockLength))
     {
         if (logError)
         {
             fprintf(stderr, "Line %d of walls.txt: has out-of-bound coordinates.\n", line);
-            fflush(stderr);
         }
         return false;
     }
@@ -175,7 +199,6 @@ bool isValidWall(struct Wall wall, int line, bool logError)
         if (logError)
         {
             fprintf(stderr, "Line %d of walls.txt: Walls can not be diagonal.\n", line);
-            fflush(stderr);
         }
         return false;
     }
@@ -190,12 +213,11 @@ bool isValidWall(struct Wall wall, int line, bool logError)
         for (int i = 0; i < wallLength; i++)
         {
             CellCord cell = {wall.floor, wall.startBlockWidth, l++};
-            if (maze[cell.floor][cell.width][cell.length].cellType != ACTIVE_CELL)
+            if (cellTypeOf(m->cells[cellIndex(m, cell)]) != ACTIVE_CELL)
             {
                 if (logError)
                 {
                     fprintf(stderr, "Line %d of walls.txt: Wall overlap with special cell or object.\n", line);
-                    fflush(stderr);
                 }
                 return false;
             }
@@ -207,87 +229,54 @@ bool isValidWall(struct Wall wall, int line, bool logError)
         for (int i = 0; i < wallWidth; i++)
         {
             CellCord cell = {wall.floor, w++, wall.startBlockLength};
-            if (maze[cell.floor][cell.width][cell.length].cellType != ACTIVE_CELL)
+            if (cellTypeOf(m->cells[cellIndex(m, cell)]) != ACTIVE_CELL)
             {
                 if (logError)
                 {
                     fprintf(stderr, "Line %d of walls.txt: Wall overlap with special cell or object.\n", line);
-                    fflush(stderr);
                 }
                 return false;
             }
         }
     }
 
-    // prevent full barrier walls depending on floor-specific rules
-    if (wall.floor == 1)
-    {
-        if (wall.startBlockWidth < 6 && isHorizontal && wallLength >= 8)
-        {
-            if (logError)
-            {
-                fprintf(stderr, "Line %d of walls.txt: Wall is a full horizontal barrier on floor 1.\n", line);
-                fflush(stderr);
-            }
-            return false;
-        }
-        if (wall.startBlockLength > 7 && wall.startBlockLength < 17 && isVertical && wallWidth >= 4)
-        {
-            if (logError)
-            {
-                fprintf(stderr, "Line %d of walls.txt: Wall is a full vertical barrier on floor 1.\n", line);
-                fflush(stderr);
-            }
-            return false;
-        }
-    }
-    else if (wall.floor == 2)
-    {
-        if (isHorizontal && wallLength >= 9)
-        {
-            if (logError)
-            {
-                fprintf(stderr, "Line %d of walls.txt: Wall is a full horizontal barrier on floor 2.\n", line);
-                fflush(stderr);
-            }
-            return false;
-        }
-    }
+    return true;
+}
 
-    if (isHorizontal && wallLength >= LENGTH)
+// ---------------------------------------GAME SUPPORT---------------------------------------
+
+// the next roll of a script, in [0, n)
+int scriptRoll(DiceScript *s, int n)
+{
+    if (s->used == MAX_SCRIPT_ROLLS)
     {
-        if (logError)
-        {
-            fprintf(stderr, "Line %d of walls.txt: Wall is the entire length of the maze.\n", line);
-            fflush(stderr);
-        }
-        return false;
+        printf("\nError: A turn rolled more than %d dice.\n", MAX_SCRIPT_ROLLS);
+        exit(1);
     }
-    else if (isVertical && wallWidth >= WIDTH)
+    s->ranges[s->used] = n;
+    return s->used < s->given ? s->rolls[s->used++] : (s->used++, 0);
+}
+
+// a roll in [0, n) from the game's rng, or the next one of its script
+int rollBelow(Game *g, int n)
+{
+    if (g->script)
     {
-        if (logError)
-        {
-            fprintf(stderr, "Line %d of walls.txt: Wall is the entire width of the maze.\n", line);
-            fflush(stderr);
-        }
-        return false;
+        return scriptRoll(g->script, n);
     }
-
-    return true;
+    return (int)rngBelow(&g->rng, n);
 }
 
-// ---------------------------------------GAME SUPPORT---------------------------------------
-
 // roll movement dice
-int rollMovementDice()
+int rollMovementDice(Game *g)
 {
-    return (rand() % 6) + 1;
+    return rollBelow(g, 6) + 1;
 }
 
 // roll direction dice
-Direction rollDirectionDice()
+Direction rollDirectionDice(Game *g)
 {
-    int face = rand() % 6 + 1;
+    int face = rollBelow(g, 6) + 1;
     switch (face)
     {
     case 2:
@@ -303,35 +292,116 @@ Direction rollDirectionDice()
     }
 }
 
+// the direction a roll in [0, 3) gives a stair when the stairs change
+StairDirection flippedDirection(int roll)
+{
+    switch (roll)
+    {
+    case 1:
+        return UP;
+    case 2:
+        return DOWN;
+
+    default:
+        return BI_DIR;
+    }
+}
+
 // change stair direction randomly
-void changeStairDirection()
+void changeStairDirection(Game *g)
+{
+    for (int i = 0; i < g->maze->no_Stairs; i++)
+    {
+        g->stairDirs[i] = flippedDirection((int)rngBelow(&g->rng, 3));
+    }
+}
+
+// the direction of a stair, or with a script that rolls the stairs the one it rolled for the stair this turn
+StairDirection stairDirection(const Game *g, int stair)
 {
-    for (int i = 0; i < no_Stairs; i++)
+    DiceScript *s = g->script;
+    if (!s || !s->rollStairs)
     {
-        switch (rand() % 3)
+        return g->stairDirs[stair];
+    }
+    for (int i = 0; i < s->no_StairRolls; i++)
+    {
+        if (s->stairIds[i] == stair)
         {
-        case 1:
-            stairs[i].dir = UP;
-            break;
-        case 2:
-            stairs[i].dir = DOWN;
-            break;
-
-        default:
-            stairs[i].dir = BI_DIR;
-            break;
+            return s->stairDirs[i];
         }
     }
+    StairDirection dir = flippedDirection(scriptRoll(s, 3));
+    s->stairIds[s->no_StairRolls] = stair;
+    s->stairDirs[s->no_StairRolls++] = dir;
+    return dir;
+}
+
+// format cell coordinate into buffer (at least CORD_STR_SIZE chars) -> format - [0, 0, ,0]
+const char *cordToString(CellCord c, char *buffer)
+{
+    snprintf(buffer, CORD_STR_SIZE, "[%d, %d, %d]", c.floor, c.width, c.length);
+    return buffer;
 }
 
-// format cell coordinate to string -> format - [0, 0, ,0]
-const char *cordToString(CellCord c)
+// name of a player into buffer (at least NAME_STR_SIZE chars), A to Z for the first players and P27 on after them
+const char *playerName(int player, char *buffer)
 {
-    static char buffer[20];
-    snprintf(buffer, sizeof(buffer), "[%d, %d, %d]", c.floor, c.width, c.length);
+    if (player < 26)
+    {
+        snprintf(buffer, NAME_STR_SIZE, "%c", 'A' + player);
+    }
+    else
+    {
+        snprintf(buffer, NAME_STR_SIZE, "P%d", player + 1);
+    }
     return buffer;
 }
 
+// ----------------------------------------ARENA---------------------------------------
+
+// room a block takes in the arena, blocks are rounded up to whole cache lines
+size_t arenaBlockSize(size_t bytes) { return (bytes + 63) & ~(size_t)63; }
+
+// size is the sum of the arenaBlockSize of every block that will be taken
+void arenaInit(Arena *a, size_t size)
+{
+    a->base = (char *)malloc(size + 64); // room to move the first block onto a cache line
+    a->size = size + 64;
+    a->used = 0;
+    if (!a->base)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+}
+
+// next block of the arena, starting on a cache line
+void *arenaAlloc(Arena *a, size_t bytes)
+{
+    size_t start = (((uintptr_t)a->base + a->used + 63) & ~(uintptr_t)63) - (uintptr_t)a->base;
+    if (start + bytes > a->size)
+    {
+        printf("\nError: Arena of %zu bytes is full.\n", a->size);
+        exit(1);
+    }
+    a->used = start + arenaBlockSize(bytes);
+    return a->base + start;
+}
+
+void arenaFree(Arena *a)
+{
+    free(a->base);
+    *a = (Arena){0};
+}
+
+// ----------------------------------------BITBOARD SUPPORT---------------------------------------
+
+// bit l of a packed row
+bool rowBit(const uint64_t *row, int l) { return (row[l / 64] >> (l % 64)) & 1; }
+
+void setRowBit(uint64_t *row, int l) { row[l / 64] |= (uint64_t)1 << (l % 64); }
+
 // ----------------------------------------PLAYER MOVE SUPPORT---------------------------------------
 
 // find the coordinates of the next cell
@@ -359,36 +429,115 @@ CellCord getNextCellCoord(CellCord current, Direction dir)
 }
 
 // find the next cell
-struct Cell getNextCell(CellCord nextCell) { return maze[nextCell.floor][nextCell.width][nextCell.length]; }
+Cell getNextCell(const Maze *m, CellCord nextCell) { return m->cells[cellIndex(m, nextCell)]; }
 
 // get a random bawana cell
-struct BawanaCell getRandomBawanaCell() { return bawanaCells[rand() % no_BawanaCells]; }
+struct BawanaCell getRandomBawanaCell(Game *g) { return g->maze->bawanaCells[rollBelow(g, g->maze->no_BawanaCells)]; }
+
+// ----------------------------------------PLAYER OCCUPANCY---------------------------------------
+// the players on a cell form a doubly linked list headed by the cell, so a capture looks at the players on one
+// cell instead of all of them. every change of a player's cell goes through setPlayerCell
+
+void linkPlayer(Game *g, int p)
+{
+    Players *ps = &g->players;
+    int cell = cellIndex(g->maze, ps->currentCell[p]);
+    ps->prev[p] = -1;
+    ps->next[p] = ps->occupant[cell];
+    if (ps->next[p] != -1)
+    {
+        ps->prev[ps->next[p]] = p;
+    }
+    ps->occupant[cell] = p;
+}
+
+void unlinkPlayer(Game *g, int p)
+{
+    Players *ps = &g->players;
+    if (ps->prev[p] != -1)
+    {
+        ps->next[ps->prev[p]] = ps->next[p];
+    }
+    else
+    {
+        ps->occupant[cellIndex(g->maze, ps->currentCell[p])] = ps->next[p];
+    }
+    if (ps->next[p] != -1)
+    {
+        ps->prev[ps->next[p]] = ps->prev[p];
+    }
+}
+
+void setPlayerCell(Game *g, int p, CellCord cell)
+{
+    unlinkPlayer(g, p);
+    g->players.currentCell[p] = cell;
+    linkPlayer(g, p);
+}
+
+// empty the cells of every player, before all their cells are set at once
+void unlinkAllPlayers(Game *g)
+{
+    Players *ps = &g->players;
+    for (int p = 0; p < ps->count; p++)
+    {
+        ps->occupant[cellIndex(g->maze, ps->currentCell[p])] = -1;
+    }
+}
+
+void linkAllPlayers(Game *g)
+{
+    for (int p = 0; p < g->players.count; p++)
+    {
+        linkPlayer(g, p);
+    }
+}
+
+int comparePlayers(const void *a, const void *b) { return *(const int *)a - *(const int *)b; }
 
 // check if player has captured a another
-void hasCapturedPlayer(char capturedBy, CellCord cell)
+void hasCapturedPlayer(Game *g, int capturedBy, CellCord cell)
 {
-    for (int i = 0; i < NO_PLAYERS; i++)
+    PROBE(PROBE_CAPTURE);
+    Players *ps = &g->players;
+    int index = cellIndex(g->maze, cell);
+    int p = ps->occupant[index];
+    int count = 0;
+    ps->occupant[index] = -1; // taken apart and built again with only capturedBy on it
+    while (p != -1)
     {
-        if (players[i].name != capturedBy && isSameCord(players[i].currentCell, cell))
+        int next = ps->next[p];
+        if (p != capturedBy)
+        {
+            ps->currentCell[p] = g->maze->startCells[p];
+            ps->captured[count++] = p;
+        }
+        linkPlayer(g, p);
+        p = next;
+    }
+
+    if (g->sink)
+    { // told in player order, as the list holds them in the order they came
+        qsort(ps->captured, count, sizeof(int), comparePlayers);
+        for (int i = 0; i < count; i++)
         {
-            players[i].currentCell = players[i].startCell;
-            printf("%c has been captured by %c at %s. Player %c has send to his starting location in starting area.\n",
-                   players[i].name, capturedBy, cordToString(cell), players[i].name);
+            EMIT(g, {.kind = EVENT_CAPTURE, .player = ps->captured[i], .other = capturedBy, .to = cell});
         }
     }
 }
 
 // check if player has returned to starting area
-bool backToStartingArea(Player *p)
+bool backToStartingArea(Game *g, int p)
 {
-    if (getNextCell(p->currentCell).cellType == STARTING_AREA_CELL)
+    Players *ps = &g->players;
+    if (cellTypeOf(getNextCell(g->maze, ps->currentCell[p])) == STARTING_AREA_CELL)
     {
-        p->currentCell = p->startCell;
-        p->dir = p->startDir;
-        p->status = STARTING_AREA;
+        setPlayerCell(g, p, g->maze->startCells[p]);
+        ps->dir[p] = g->maze->startDirs[p];
+        ps->status[p] = STARTING_AREA;
         return true;
     }
     return false;
 }
 
-#endif
\ No newline at end of file
+#endif
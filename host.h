@@ -0,0 +1,406 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdarg.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+#include "sim.h"
+
+// ----------------------------------------GAME POOL---------------------------------------
+// every game of the host is played on the one loaded maze. games come from slabs of ready made games whose arrays
+// were allocated when the slab was, an ended game goes back on the free list and the next new game reuses it as it is
+
+#define POOL_SLAB_GAMES 256
+
+typedef struct
+{
+    Game game;
+    uint32_t generation; // bumped when the game ends, so the ids it was known by find nothing any more
+    int nextFree;        // next slot of the free list
+    bool live;
+} PoolSlot;
+
+typedef struct
+{
+    const Maze *maze;
+    unsigned int seed;
+    PoolSlot **slabs; // POOL_SLAB_GAMES slots each, slabs never move so games keep their address
+    int no_Slabs;
+    int freeHead; // -1 when every slot is live
+    int live;
+    long created; // games created so far, the dice stream of a game is its number
+} GamePool;
+
+void initGamePool(GamePool *pool, const Maze *m, unsigned int seed)
+{
+    *pool = (GamePool){.maze = m, .seed = seed};
+    pool->freeHead = -1;
+}
+
+// a slab more of games, all on the free list
+void growGamePool(GamePool *pool)
+{
+    PoolSlot **slabs = (PoolSlot **)realloc(pool->slabs, (pool->no_Slabs + 1) * sizeof(PoolSlot *));
+    PoolSlot *slab = (PoolSlot *)calloc(POOL_SLAB_GAMES, sizeof(PoolSlot));
+    if (!slabs || !slab)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    pool->slabs = slabs;
+    pool->slabs[pool->no_Slabs] = slab;
+    for (int i = POOL_SLAB_GAMES - 1; i >= 0; i--)
+    {
+        initGame(&slab[i].game, pool->maze, pool->seed, 0);
+        slab[i].nextFree = pool->freeHead;
+        pool->freeHead = pool->no_Slabs * POOL_SLAB_GAMES + i;
+    }
+    pool->no_Slabs++;
+}
+
+PoolSlot *poolSlot(const GamePool *pool, int slot) { return &pool->slabs[slot / POOL_SLAB_GAMES][slot % POOL_SLAB_GAMES]; }
+
+// a game in round 0 on the dice stream (seed, game number), returns its id
+uint64_t createPooledGame(GamePool *pool, unsigned int seed)
+{
+    if (pool->freeHead == -1)
+    {
+        growGamePool(pool);
+    }
+    int slot = pool->freeHead;
+    PoolSlot *s = poolSlot(pool, slot);
+    pool->freeHead = s->nextFree;
+    s->live = true;
+    pool->live++;
+
+    rngInit(&s->game.rng, seed, (uint64_t)pool->created++);
+    resetGame(&s->game);
+    return (uint64_t)s->generation << 32 | (uint32_t)slot;
+}
+
+// the live game with the id, NULL if it has ended or never was
+Game *findPooledGame(const GamePool *pool, uint64_t id)
+{
+    uint32_t slot = (uint32_t)id;
+    if (slot >= (uint32_t)(pool->no_Slabs * POOL_SLAB_GAMES))
+    {
+        return NULL;
+    }
+    PoolSlot *s = poolSlot(pool, (int)slot);
+    return s->live && s->generation == (uint32_t)(id >> 32) ? &s->game : NULL;
+}
+
+bool endPooledGame(GamePool *pool, uint64_t id)
+{
+    if (!findPooledGame(pool, id))
+    {
+        return false;
+    }
+    int slot = (int)(uint32_t)id;
+    PoolSlot *s = poolSlot(pool, slot);
+    s->live = false;
+    s->generation++;
+    s->nextFree = pool->freeHead;
+    pool->freeHead = slot;
+    pool->live--;
+    return true;
+}
+
+void freeGamePool(GamePool *pool)
+{
+    for (int i = 0; i < pool->no_Slabs; i++)
+    {
+        for (int j = 0; j < POOL_SLAB_GAMES; j++)
+        {
+            freeGame(&pool->slabs[i][j].game);
+        }
+        free(pool->slabs[i]);
+    }
+    free(pool->slabs);
+    *pool = (GamePool){0};
+}
+
+// ----------------------------------------SESSION PROTOCOL---------------------------------------
+// one request per line, one reply line per request, "OK ..." or "ERR <reason>":
+//   NEW [seed]           -> OK <id>                      a new game, on the host's seed if none is given
+//   PLAY <id> [rounds]   -> OK <round> <winner> <turns> <finished>
+//                                                        play on 1 or more rounds, winner is -1 while the game runs.
+//                                                        finished is 1 once it is won or ran out of rounds
+//   STATE <id>           -> OK <round> <winner> <players> and floor,width,length,movement points of each player
+//   END <id>             -> OK                           the game is dropped and its id finds nothing any more
+//   STATS                -> OK <live games> <games created> <pooled games>
+//   SHUTDOWN             -> OK                           the host stops once the reply is sent
+
+#define HOST_LINE_SIZE 256
+#define HOST_MAX_CLIENTS 1024
+
+typedef struct
+{
+    int in, out; // the same socket, or stdin and stdout for a pipe
+    char line[HOST_LINE_SIZE];
+    int used;
+} HostClient;
+
+typedef struct
+{
+    GamePool pool;
+    bool stopping;
+    char *reply; // room for the longest reply, the state of every player
+    size_t replySize;
+    long requests;
+} Host;
+
+void hostReply(Host *h, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vsnprintf(h->reply, h->replySize, format, args);
+    va_end(args);
+}
+
+// the reply to one request line into h->reply
+void handleRequest(Host *h, char *line)
+{
+    char command[16];
+    unsigned long long id;
+    long count = 1;
+    int fields = sscanf(line, "%15s %llu %ld", command, &id, &count);
+    h->requests++;
+    if (fields < 1)
+    {
+        hostReply(h, "ERR empty request");
+    }
+    else if (strcmp(command, "NEW") == 0)
+    {
+        unsigned int seed = fields >= 2 ? (unsigned int)id : h->pool.seed;
+        hostReply(h, "OK %llu", (unsigned long long)createPooledGame(&h->pool, seed));
+    }
+    else if (strcmp(command, "STATS") == 0)
+    {
+        hostReply(h, "OK %d %ld %d", h->pool.live, h->pool.created, h->pool.no_Slabs * POOL_SLAB_GAMES);
+    }
+    else if (strcmp(command, "SHUTDOWN") == 0)
+    {
+        h->stopping = true;
+        hostReply(h, "OK");
+    }
+    else if (strcmp(command, "PLAY") != 0 && strcmp(command, "STATE") != 0 && strcmp(command, "END") != 0)
+    {
+        hostReply(h, "ERR unknown command %s", command);
+    }
+    else if (fields < 2)
+    {
+        hostReply(h, "ERR %s needs a game id", command);
+    }
+    else if (strcmp(command, "END") == 0)
+    {
+        if (endPooledGame(&h->pool, id))
+        {
+            hostReply(h, "OK");
+        }
+        else
+        {
+            hostReply(h, "ERR no game %llu", id);
+        }
+    }
+    else
+    {
+        Game *g = findPooledGame(&h->pool, id);
+        if (!g)
+        {
+            hostReply(h, "ERR no game %llu", id);
+        }
+        else if (strcmp(command, "PLAY") == 0 && (count < 1 || count > MAX_ROUNDS))
+        {
+            hostReply(h, "ERR rounds must be between 1 and %d", MAX_ROUNDS);
+        }
+        else if (strcmp(command, "PLAY") == 0)
+        {
+            int before = g->gameRound;
+            bool ended = g->winner != NO_WINNER;
+            continueGame(g, (int)(before + count < MAX_ROUNDS ? before + count : MAX_ROUNDS));
+            // whole rounds played, and the turns of the round the flag was captured in
+            long turns = ended ? 0 : (long)(g->gameRound - before) * g->players.count + (g->winner != NO_WINNER ? g->winner + 1 : 0);
+            bool finished = g->winner != NO_WINNER || g->gameRound >= MAX_ROUNDS;
+            hostReply(h, "OK %d %d %ld %d", g->gameRound, g->winner, turns, finished);
+        }
+        else // STATE
+        {
+            int at = snprintf(h->reply, h->replySize, "OK %d %d %d", g->gameRound, g->winner, g->players.count);
+            for (int p = 0; p < g->players.count; p++)
+            {
+                CellCord c = g->players.currentCell[p];
+                at += snprintf(h->reply + at, h->replySize - at, " %d,%d,%d,%d", c.floor, c.width, c.length, g->players.movementPoints[p]);
+            }
+        }
+    }
+}
+
+#ifndef _WIN32
+
+bool writeAll(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+// answer every whole line the client has sent, false once it is gone
+bool serveClient(Host *h, HostClient *c)
+{
+    ssize_t got = read(c->in, c->line + c->used, HOST_LINE_SIZE - c->used);
+    if (got <= 0)
+    {
+        return false;
+    }
+    c->used += (int)got;
+
+    int start = 0;
+    for (int i = 0; i < c->used; i++)
+    {
+        if (c->line[i] == '\n')
+        {
+            c->line[i] = '\0';
+            handleRequest(h, c->line + start);
+            size_t length = strlen(h->reply);
+            h->reply[length] = '\n';
+            if (!writeAll(c->out, h->reply, length + 1))
+            {
+                return false;
+            }
+            start = i + 1;
+        }
+    }
+    if (start == 0 && c->used == HOST_LINE_SIZE)
+    {
+        const char *tooLong = "ERR request too long\n";
+        writeAll(c->out, tooLong, strlen(tooLong));
+        return false;
+    }
+    memmove(c->line, c->line + start, c->used - start);
+    c->used -= start;
+    return true;
+}
+
+int openHostSocket(const char *path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+        printf("\nError: Socket path %s is too long.\n", path);
+        exit(1);
+    }
+    strcpy(address.sun_path, path);
+    unlink(path); // left by a host that did not shut down
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(fd, 128) != 0)
+    {
+        printf("\nError: Could not listen on %s.\n", path);
+        exit(1);
+    }
+    return fd;
+}
+
+// host games for the clients of the Unix socket at path, or for stdin and stdout if path is "-", until SHUTDOWN
+void runHost(const Maze *m, unsigned int seed, const char *path)
+{
+    static Host host;
+    initGamePool(&host.pool, m, seed);
+    host.replySize = 64 + (size_t)m->no_Players * 48;
+    host.reply = (char *)malloc(host.replySize);
+    static struct pollfd fds[HOST_MAX_CLIENTS + 1];
+    static HostClient clients[HOST_MAX_CLIENTS + 1];
+    if (!host.reply)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    signal(SIGPIPE, SIG_IGN); // a client that left is seen as a failed write
+
+    bool piped = strcmp(path, "-") == 0;
+    int listener = piped ? -1 : openHostSocket(path);
+    int no_Fds = 1; // fds[0] is the listener, or stdin
+    fds[0] = (struct pollfd){.fd = piped ? STDIN_FILENO : listener, .events = POLLIN};
+    clients[0] = (HostClient){.in = STDIN_FILENO, .out = STDOUT_FILENO};
+    if (!piped)
+    {
+        printf("\nHosting games on %s\n", path);
+        fflush(stdout);
+    }
+
+    double start = nowSeconds();
+    while (!host.stopping && (!piped || no_Fds > 0) && poll(fds, no_Fds, -1) >= 0)
+    {
+        if (!piped && fds[0].revents & POLLIN)
+        {
+            int fd = accept(listener, NULL, NULL);
+            if (fd >= 0 && no_Fds <= HOST_MAX_CLIENTS)
+            {
+                fds[no_Fds] = (struct pollfd){.fd = fd, .events = POLLIN};
+                clients[no_Fds++] = (HostClient){.in = fd, .out = fd};
+            }
+            else if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        for (int i = piped ? 0 : 1; i < no_Fds && !host.stopping; i++)
+        {
+            if (fds[i].revents && !serveClient(&host, &clients[i]))
+            { // the last client takes the place of the one that left
+                if (!piped)
+                {
+                    close(fds[i].fd);
+                }
+                fds[i] = fds[--no_Fds];
+                clients[i] = clients[no_Fds];
+                fds[i].revents = 0;
+                i--;
+            }
+        }
+    }
+
+    for (int i = 1; i < no_Fds; i++)
+    {
+        close(fds[i].fd);
+    }
+    if (!piped)
+    {
+        close(listener);
+        unlink(path);
+        printf("\nHost stopped: %ld requests in %.3f s, %ld games created, %d games pooled\n", host.requests,
+               nowSeconds() - start, host.pool.created, host.pool.no_Slabs * POOL_SLAB_GAMES);
+    }
+    free(host.reply);
+    freeGamePool(&host.pool);
+}
+
+#else
+
+void runHost(const Maze *m, unsigned int seed, const char *path)
+{
+    printf("\nError: The session host needs Unix sockets and pipes, it is not built for Windows.\n");
+    exit(1);
+}
+
+#endif
+
+#endif
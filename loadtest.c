@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------HOST LOAD TEST---------------------------------------
+// build: gcc -O2 -pthread loadtest.c -o loadtest, and run it against a host started with a.exe --host <socket>.
+// usage: loadtest <socket> [--clients <C>] [--games <G>] [--requests <R>] [--rounds <N>] [--shutdown]
+// C clients on their own connections keep G games each going, sending R requests that play N rounds of a game
+// one at a time and starting a new game in place of every one that ends. reports the player turns played per
+// second and the latency of a request, which with the default of 1 round is the time of one round of turns
+
+#define LOAD_LINE_SIZE 256
+
+typedef struct
+{
+    const char *path;
+    int games;
+    long requests;
+    int rounds;
+
+    double *latencies; // [request] seconds from sending it to reading its reply
+    long turns;
+    long gamesEnded;
+    bool failed;
+} LoadClient;
+
+double loadNow()
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#ifndef _WIN32
+
+typedef struct
+{
+    int fd;
+    char buffer[LOAD_LINE_SIZE];
+    int used;
+} Connection;
+
+// send a request line and read its reply line into reply, false if the host is gone or says ERR
+bool request(Connection *c, const char *line, char *reply)
+{
+    size_t length = strlen(line);
+    if (write(c->fd, line, length) != (ssize_t)length)
+    {
+        return false;
+    }
+    while (1)
+    {
+        char *end = memchr(c->buffer, '\n', c->used);
+        if (end)
+        {
+            int size = (int)(end - c->buffer);
+            memcpy(reply, c->buffer, size);
+            reply[size] = '\0';
+            memmove(c->buffer, end + 1, c->used - size - 1);
+            c->used -= size + 1;
+            return strncmp(reply, "OK", 2) == 0;
+        }
+        if (c->used == LOAD_LINE_SIZE)
+        {
+            return false;
+        }
+        ssize_t got = read(c->fd, c->buffer + c->used, LOAD_LINE_SIZE - c->used);
+        if (got <= 0)
+        {
+            return false;
+        }
+        c->used += (int)got;
+    }
+}
+
+bool connectHost(Connection *c, const char *path)
+{
+    struct sockaddr_un address = {0};
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    c->used = 0;
+    c->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    return c->fd >= 0 && connect(c->fd, (struct sockaddr *)&address, sizeof(address)) == 0;
+}
+
+bool newGame(Connection *c, unsigned long long *id)
+{
+    char reply[LOAD_LINE_SIZE];
+    return request(c, "NEW\n", reply) && sscanf(reply, "OK %llu", id) == 1;
+}
+
+void *loadClientRun(void *arg)
+{
+    LoadClient *lc = (LoadClient *)arg;
+    Connection c;
+    unsigned long long *ids = (unsigned long long *)malloc(lc->games * sizeof(unsigned long long));
+    char line[LOAD_LINE_SIZE], reply[LOAD_LINE_SIZE];
+    lc->failed = !ids || !connectHost(&c, lc->path);
+    for (int i = 0; i < lc->games && !lc->failed; i++)
+    {
+        lc->failed = !newGame(&c, &ids[i]);
+    }
+
+    for (long r = 0; r < lc->requests && !lc->failed; r++)
+    {
+        int i = (int)(r % lc->games);
+        snprintf(line, sizeof(line), "PLAY %llu %d\n", ids[i], lc->rounds);
+        double start = loadNow();
+        int round, winner, finished;
+        long turns;
+        if (!request(&c, line, reply) || sscanf(reply, "OK %d %d %ld %d", &round, &winner, &turns, &finished) != 4)
+        {
+            lc->failed = true;
+            break;
+        }
+        lc->latencies[r] = loadNow() - start;
+        lc->turns += turns;
+        if (finished)
+        { // won or out of rounds, the next request on this slot plays a fresh game
+            snprintf(line, sizeof(line), "END %llu\n", ids[i]);
+            lc->failed = !request(&c, line, reply) || !newGame(&c, &ids[i]);
+            lc->gamesEnded++;
+        }
+    }
+
+    for (int i = 0; i < lc->games && !lc->failed; i++)
+    {
+        snprintf(line, sizeof(line), "END %llu\n", ids[i]);
+        request(&c, line, reply);
+    }
+    close(c.fd);
+    free(ids);
+    return NULL;
+}
+
+int compareLatencies(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+    int clients = 4;
+    int games = 64;
+    long requests = 20000;
+    int rounds = 1;
+    bool shutdown = false;
+    const char *path = argc > 1 ? argv[1] : NULL;
+    for (int i = 2; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--clients") == 0)
+        {
+            clients = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--games") == 0)
+        {
+            games = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--requests") == 0)
+        {
+            requests = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--rounds") == 0)
+        {
+            rounds = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--shutdown") == 0)
+        {
+            shutdown = true;
+        }
+        else
+        {
+            path = NULL;
+            break;
+        }
+    }
+    if (!path || clients < 1 || clients > 1000 || games < 1 || requests < 1 || rounds < 1)
+    {
+        printf("\nUsage: %s <socket> [--clients <1..1000>] [--games <per client>] [--requests <per client>] [--rounds <per request>] [--shutdown]\n", argv[0]);
+        return 1;
+    }
+
+    LoadClient *lcs = (LoadClient *)calloc(clients, sizeof(LoadClient));
+    pthread_t *threads = (pthread_t *)malloc(clients * sizeof(pthread_t));
+    double *latencies = (double *)malloc(clients * requests * sizeof(double));
+    if (!lcs || !threads || !latencies)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        return 1;
+    }
+    double start = loadNow();
+    for (int i = 0; i < clients; i++)
+    {
+        lcs[i] = (LoadClient){.path = path, .games = games, .requests = requests, .rounds = rounds, .latencies = latencies + i * requests};
+        if (pthread_create(&threads[i], NULL, loadClientRun, &lcs[i]) != 0)
+        {
+            printf("\nError: Could not start client thread.\n");
+            return 1;
+        }
+    }
+    long turns = 0, ended = 0;
+    bool failed = false;
+    for (int i = 0; i < clients; i++)
+    {
+        pthread_join(threads[i], NULL);
+        turns += lcs[i].turns;
+        ended += lcs[i].gamesEnded;
+        failed |= lcs[i].failed;
+    }
+    double elapsed = loadNow() - start;
+    if (failed)
+    {
+        printf("\nError: Lost the host at %s, or it refused a request.\n", path);
+        return 1;
+    }
+
+    long total = clients * requests;
+    qsort(latencies, total, sizeof(double), compareLatencies);
+    printf("\nLoad test of %s: %d clients keeping %d games each, %ld requests of %d rounds\n", path, clients, games, total, rounds);
+    printf("  %ld turns in %.3f s: %.0f turns/sec, %.0f requests/sec, %ld games finished\n", turns, elapsed,
+           turns / elapsed, total / elapsed, ended);
+    printf("  request latency (us): p50 %.1f  p99 %.1f  max %.1f\n", latencies[total / 2] * 1e6,
+           latencies[(long)(total * 0.99)] * 1e6, latencies[total - 1] * 1e6);
+
+    if (shutdown)
+    {
+        Connection c;
+        char reply[LOAD_LINE_SIZE];
+        if (connectHost(&c, path))
+        {
+            request(&c, "SHUTDOWN\n", reply);
+            close(c.fd);
+        }
+    }
+    free(latencies);
+    free(threads);
+    free(lcs);
+    return 0;
+}
+
+#else
+
+int main()
+{
+    printf("\nError: The load test talks to the host over a Unix socket, it is not built for Windows.\n");
+    return 1;
+}
+
+#endif
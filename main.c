@@ -1,141 +1,384 @@
 #include "maze.h"
 #include "play.h"
+#include "snapshot.h"
+#include "events.h"
+#include "sim.h"
+#include "host.h"
+#include "solve.h"
+#include "sweep.h"
+#include "generate.h"
+#include "globals.h"
 
-// ----------------------------------------GLOBAL VARIABLES---------------------------------------
-
-// constants
-const CellCord BawanaEntry = {0, 9, 19};
-
-const CellCord specialCells[] = {BawanaEntry, {0, 6, 12}, {0, 5, 12}, {0, 9, 8}, {0, 9, 7}, {0, 9, 16}, {0, 9, 17}};
-
-const char *stringDirections[] = {"NORTH", "EAST", "SOUTH", "WEST", "EMPTY"};
-
-const char *stringBawanaEffects[] = {"POISONED", "DISORIENTED", "TRIGGERED", "HAPPY", "RANDOM"};
-
-// arrays
-struct Cell maze[FLOORS][WIDTH][LENGTH];
-Player players[NO_PLAYERS];
-
-CellCord Flag;
-
-// array pointers
-struct Stair *stairs = NULL;
-struct Pole *poles = NULL;
-struct Wall *walls = NULL;
-struct BawanaCell *bawanaCells = NULL;
-
-// counters
-int no_Stairs = 0;
-int no_Poles = 0;
-int no_Walls = 0;
-int no_BawanaCells = 0;
-
-int gameRound = 0;
-
-// ---------------------------------------CHECK IS FLAG REACHERABLE---------------------------------------
-bool isFlagReachable(CellCord start)
+// ---------------------------------------MAIN---------------------------------------
+// usage: a.exe                            -> play one narrated game
+//        a.exe --batch <N> [--threads <T>] -> play N silent games on T threads and report games/sec
+//        a.exe --scale <N> [--threads <T>] -> play N games on 1..T threads and report the scaling
+//        a.exe --replay <I>                -> narrate game number I of a batch on its own
+//        a.exe --bench-rng <N>             -> time N dice rolls of rand() against the game rng
+//        a.exe --bench-moves <N>           -> time N moves walked step by step against the step table
+//        a.exe --bench-reach <N>           -> time N flag reachability checks, BFS against flood fill
+//        a.exe --bench-flips <N>           -> time keeping flag reachability current over N stair flips
+//        a.exe --bench-size <N>            -> time setup, validation and N turns on mazes of growing size
+//        a.exe --bench-load <N>            -> time loading stair files of up to N stairs
+//        a.exe --bench-players <N>         -> time N rounds of games of 3 up to 10000 players
+//        a.exe ... --players <N>           -> play any of the above with N players, the ones after C start on cells
+//                                             drawn from the edge of the starting area
+//        a.exe --what-if <R> [--replay <I>] [--branches <N>] [--save-game <file> | --load-game <file>]
+//                                          -> play game I to round R, or load it, then play it on along N branches
+//        a.exe --solve [--load-game <file>]
+//                                          -> estimate every player's chance of reaching the flag, expected rounds to
+//                                             it and chance of winning from approximate Markov chains of their turns,
+//                                             from the start or from a saved game
+//        a.exe --sweep <file> [--games <K>] [--sweep-out <file>] [--threads <T>]
+//                                          -> play K games of every layout variant the file lists on T threads and
+//                                             report win rates, game lengths and Bawana visits, see sweep.h
+//        a.exe --generate <N> [--generate-out <dir>] [--snapshot-layouts] [--threads <T>]
+//                                          -> draw N random valid layouts for the maze size of maze.txt on T threads,
+//                                             written into dir as text files and a sweep.txt, or as maze snapshots
+//        a.exe --bench-startup <N>         -> time N startups from the text files against a maze snapshot
+//        a.exe --compile-maze <file>       -> build the maze from the text files and seed, write it as a snapshot
+//        a.exe --maze-snapshot <file> ...  -> run any of the above on a compiled maze instead of the text files
+//        a.exe --host <socket | ->         -> host many games at once for the clients of a Unix socket, or over stdin
+//                                             and stdout, see SESSION PROTOCOL in host.h and loadtest.c
+//        a.exe ... [--log <file>] [--verbosity <silent|summary|full>]
+//                                          -> tell the game or batch into a file, gzipped if it ends in .gz, at a level
+//                                             (default full for one game, silent for a batch or summary with a log)
+//        a.exe ... [--profile text | --profile-json <file>]
+//                                          -> at exit report the time spent in the load, reach and turn functions,
+//                                             in a build with -DSNL_PROFILE
+int main(int argc, char *argv[])
 {
-    // BFS queue: store CellCord
-    CellCord queue[1000]; // Fixed size for simplicity; adjust if needed
-    int front = 0, rear = 0;
-    bool visited[FLOORS][WIDTH][LENGTH] = {false};
-
-    queue[rear++] = start;
-    visited[start.floor][start.width][start.length] = true;
-
-    while (front < rear)
+    long batchGames = 0;
+    long scaleGames = 0;
+    long replayGame = 0;
+    long rngRolls = 0;
+    long benchMoves = 0;
+    long benchReach = 0;
+    long benchFlips = 0;
+    long benchSize = 0;
+    long benchLoad = 0;
+    long benchPlayers = 0;
+    long players = DEFAULT_PLAYERS;
+    long benchStartup = 0;
+    long whatIfRound = 0;
+    long branches = 1000;
+    const char *saveGamePath = NULL;
+    const char *loadGamePath = NULL;
+    const char *compilePath = NULL;
+    const char *snapshotPath = NULL;
+    const char *hostPath = NULL;
+    bool solve = false;
+    const char *sweepPath = NULL;
+    const char *sweepOutPath = NULL;
+    long sweepGames = 1000;
+    long generateCount = 0;
+    const char *generatePath = NULL;
+    bool snapshotLayouts = false;
+    const char *logPath = NULL;
+    int verbosity = -2; // not given
+    bool profile = false;
+    const char *profilePath = NULL;
+    int threads = cpuCount();
+    for (int i = 1; i < argc; i++)
     {
-        CellCord curr = queue[front++];
-
-        if (isSameCord(curr, Flag))
+        if (i + 1 < argc && strcmp(argv[i], "--batch") == 0)
         {
-            return true; // Flag reached
+            batchGames = atol(argv[++i]);
         }
-
-        // Check neighbors: N, E, S, W
-        Direction dirs[] = {NORTH, EAST, SOUTH, WEST};
-        for (int d = 0; d < 4; d++)
+        else if (i + 1 < argc && strcmp(argv[i], "--scale") == 0)
         {
-            CellCord next = getNextCellCoord(curr, dirs[d]);
-            if (isValidCordinates(next) && !isBlockedCell(next) && !visited[next.floor][next.width][next.length])
-            {
-                visited[next.floor][next.width][next.length] = true;
-                queue[rear++] = next;
-            }
+            scaleGames = atol(argv[++i]);
         }
-
-        // Handle stairs if on a stair cell
-        struct Cell cell = maze[curr.floor][curr.width][curr.length];
-        if (cell.cellType == STAIR_CELL)
-        {
-            CellCord stairEnd = curr; // Temp
-            if (takeStair(&stairEnd, cell.cellTypeId))
-            { // Reuse takeStair to get end
-                if (!visited[stairEnd.floor][stairEnd.width][stairEnd.length])
-                {
-                    visited[stairEnd.floor][stairEnd.width][stairEnd.length] = true;
-                    queue[rear++] = stairEnd;
-                }
-            }
+        else if (i + 1 < argc && strcmp(argv[i], "--replay") == 0)
+        {
+            replayGame = atol(argv[++i]);
         }
-
-        // Handle poles if on a pole cell (down only, as per game logic)
-        if (cell.cellType == POLE_CELL)
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-rng") == 0)
+        {
+            rngRolls = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-moves") == 0)
+        {
+            benchMoves = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-reach") == 0)
+        {
+            benchReach = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-flips") == 0)
+        {
+            benchFlips = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-size") == 0)
+        {
+            benchSize = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-load") == 0)
+        {
+            benchLoad = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-players") == 0)
+        {
+            benchPlayers = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--players") == 0)
+        {
+            players = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--what-if") == 0)
+        {
+            whatIfRound = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--branches") == 0)
+        {
+            branches = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--save-game") == 0)
+        {
+            saveGamePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--load-game") == 0)
+        {
+            loadGamePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--bench-startup") == 0)
+        {
+            benchStartup = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--compile-maze") == 0)
+        {
+            compilePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--maze-snapshot") == 0)
+        {
+            snapshotPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--solve") == 0)
+        {
+            solve = true;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--sweep") == 0)
+        {
+            sweepPath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--sweep-out") == 0)
+        {
+            sweepOutPath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--games") == 0)
+        {
+            sweepGames = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--generate") == 0)
+        {
+            generateCount = atol(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--generate-out") == 0)
+        {
+            generatePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--snapshot-layouts") == 0)
+        {
+            snapshotLayouts = true;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--host") == 0)
+        {
+            hostPath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--log") == 0)
+        {
+            logPath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--verbosity") == 0)
+        {
+            verbosity = parseVerbosity(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--profile") == 0 && strcmp(argv[i + 1], "text") == 0)
+        {
+            profile = true;
+            i++;
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--profile-json") == 0)
+        {
+            profile = true;
+            profilePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else
         {
-            CellCord poleStart = curr; // Temp
-            if (takePole(&poleStart, cell.cellTypeId))
-            {
-                if (!visited[poleStart.floor][poleStart.width][poleStart.length])
-                {
-                    visited[poleStart.floor][poleStart.width][poleStart.length] = true;
-                    queue[rear++] = poleStart;
-                }
-            }
+            printf("\nUsage: %s [--batch <games> | --scale <games> | --replay <game> | --bench-rng <rolls> | --bench-moves <moves> | --bench-reach <queries> | --bench-flips <flips> | --bench-size <turns> | --bench-load <stairs> | --bench-players <rounds> | --what-if <round> | --bench-startup <runs> | --compile-maze <file> | --host <socket | -> | --solve | --sweep <file> | --generate <layouts>] [--players <count>] [--branches <count>] [--games <count>] [--sweep-out <file>] [--generate-out <dir>] [--snapshot-layouts] [--save-game <file> | --load-game <file>] [--maze-snapshot <file>] [--log <file>] [--verbosity <silent|summary|full>] [--profile text | --profile-json <file>] [--threads <count>]\n", argv[0]);
+            return 1;
         }
     }
-    return false; // Flag not reachable
-}
+    if (batchGames < 0 || scaleGames < 0 || replayGame < 0 || rngRolls < 0 || benchMoves < 0 || benchReach < 0 || benchFlips < 0 || benchSize < 0 || benchLoad < 0 || benchPlayers < 0 || benchStartup < 0 || whatIfRound < 0 || whatIfRound > MAX_ROUNDS || branches < 0 || sweepGames < 1 || generateCount < 0 || threads < 1 || threads > MAX_THREADS)
+    {
+        printf("\nError: game count must be positive and thread count between 1 and %d.\n", MAX_THREADS);
+        return 1;
+    }
+    if (players < 1 || players > MAX_PLAYERS)
+    {
+        printf("\nError: player count must be between 1 and %d.\n", MAX_PLAYERS);
+        return 1;
+    }
+    if (verbosity == -1)
+    {
+        printf("\nError: verbosity must be silent, summary or full.\n");
+        return 1;
+    }
+    if (profile)
+    {
+        requestProfileReport(profilePath);
+    }
+    bool interactive = !batchGames && !scaleGames && !rngRolls && !benchMoves && !benchReach && !benchFlips && !benchSize && !benchLoad && !benchPlayers && !benchStartup && !compilePath && !whatIfRound && !loadGamePath && !hostPath && !solve && !sweepPath && !generateCount;
 
-// ---------------------------------------CHECK IS FLAG REACHERABLE---------------------------------------
-int main()
-{
-    // write errors into log.txt file
+    // write errors into log.txt file, buffered as the loaders can log a line per rejected object
     freopen("log.txt", "a", stderr);
+    setvbuf(stderr, NULL, _IOFBF, 1 << 16);
     fprintf(stderr, "\n---------------------------------------------------------------------------------------------------------------------\n\n");
-    fflush(stderr);
 
     // game start here
-    printf("\n\t\t   ___   _   __  __ ___   ___ ___ ___ ___ _  _ ___ _ \r\n\t\t  / __| /_\\ |  \\/  | __| | _ ) __/ __|_ _| \\| / __| |\r\n\t\t | (_ |/ _ \\| |\\/| | _|  | _ \\ _| (_ || || .` \\__ \\_|\r\n\t\t  \\___/_/ \\_\\_|  |_|___| |___/___\\___|___|_|\\_|___(_)\r\n                                                     \n");
+    if (interactive)
+    {
+        printf("\n\t\t   ___   _   __  __ ___   ___ ___ ___ ___ _  _ ___ _ \r\n\t\t  / __| /_\\ |  \\/  | __| | _ ) __/ __|_ _| \\| / __| |\r\n\t\t | (_ |/ _ \\| |\\/| | _|  | _ \\ _| (_ || || .` \\__ \\_|\r\n\t\t  \\___/_/ \\_\\_|  |_|___| |___/___\\___|___|_|\\_|___(_)\r\n                                                     \n");
+    }
+
+    static Maze maze;
+    unsigned int seed = loadSeed();
+    if (rngRolls)
+    {
+        runRngBenchmark(seed, rngRolls);
+        return 0;
+    }
+    if (benchSize)
+    {
+        runSizeBenchmark(seed, benchSize);
+        return 0;
+    }
+    if (benchStartup)
+    {
+        runStartupBenchmark(seed, benchStartup);
+        return 0;
+    }
+    if (generateCount)
+    {
+        runGenerator(seed, generateCount, threads, generatePath, snapshotLayouts);
+        return 0;
+    }
+    if (sweepPath)
+    { // every variant builds its own maze
+        runSweep(sweepPath, seed, sweepGames, threads, (int)players, sweepOutPath);
+        return 0;
+    }
+    if (snapshotPath)
+    { // the snapshot carries the seed its maze was built with, the games must use the same one
+        seed = loadMazeSnapshot(&maze, snapshotPath);
+    }
+    else
+    {
+        intializeMaze(&maze, seed);
+        buildStepTable(&maze);
+    }
+    if (players != DEFAULT_PLAYERS)
+    {
+        placePlayers(&maze, (int)players, seed);
+    }
 
-    loadSeed();
-    intializeMaze();
-    for (int i = 0; i < NO_PLAYERS; i++)
+    Game game;
+    initGame(&game, &maze, seed, replayGame);
+
+    DistanceField field; // one search from the flag answers the check for every starting cell
+    initDistanceField(&field, &maze);
+    buildDistanceField(&game, &field);
+    for (int p = 0; p < maze.no_Players; p++)
     {
-        if (!isFlagReachable(players[i].startCell))
+        if (!isFlagReachableFrom(&field, maze.startCells[p]))
         { // Check from starting cells
-            printf("\nError: Flag is unreachable from player %c's starting position. Quitting Game....\n", players[i].name);
+            char name[NAME_STR_SIZE];
+            printf("\nError: Flag is unreachable from player %s's starting position. Quitting Game....\n", playerName(p, name));
             exit(1);
         }
     }
-    initPlayers();
 
-    while (true)
+    if (compilePath)
+    {
+        saveMazeSnapshot(&maze, seed, compilePath);
+        printf("\nMaze snapshot written to %s\n", compilePath);
+    }
+    else if (solve)
     {
-        printf("\n \tRound %d \n", gameRound + 1);
-        printf(" ===================== \n");
-        for (int i = 0; i < NO_PLAYERS; i++)
+        if (loadGamePath)
         {
-            printf("\n----%c's turn:----\n", players[i].name);
-            playerTurn(&players[i]);
+            loadGameFile(&game, loadGamePath);
         }
-
-        gameRound++;
-        if (gameRound % 5 == 0)
+        runSolve(&game);
+    }
+    else if (hostPath)
+    {
+        runHost(&maze, seed, hostPath);
+    }
+    else if (whatIfRound || loadGamePath)
+    {
+        runWhatIf(&maze, seed, replayGame, (int)whatIfRound, branches, loadGamePath, saveGamePath);
+    }
+    else if (batchGames)
+    {
+        Output output;
+        Verbosity level = verbosity >= 0 ? (Verbosity)verbosity : logPath ? OUTPUT_SUMMARY : OUTPUT_SILENT;
+        if (level != OUTPUT_SILENT)
+        {
+            openOutput(&output, logPath, level, threads);
+        }
+        double start = nowSeconds();
+        BatchStats stats = runBatch(&maze, seed, batchGames, threads, level != OUTPUT_SILENT ? &output : NULL, NULL);
+        long stalls = level != OUTPUT_SILENT ? closeOutput(&output) : 0;
+        printBatchStats(&stats, nowSeconds() - start);
+        if (level != OUTPUT_SILENT)
         {
-            printf("\n \\\\---Five rounds has passed. The direction of the stairs change randomly.---\\\\ \n");
-            changeStairDirection();
+            printf("  output: %ld events written, game threads waited for the writer %ld times\n", output.records, stalls);
         }
     }
+    else if (benchMoves)
+    {
+        runMoveBenchmark(&maze, seed, benchMoves);
+    }
+    else if (benchReach)
+    {
+        runReachBenchmark(&maze, seed, benchReach);
+    }
+    else if (benchFlips)
+    {
+        runFlipBenchmark(&maze, seed, benchFlips);
+    }
+    else if (benchLoad)
+    {
+        runLoadBenchmark(&maze, seed, benchLoad);
+    }
+    else if (benchPlayers)
+    {
+        runPlayerBenchmark(&maze, seed, benchPlayers);
+    }
+    else if (scaleGames)
+    {
+        runScalingBenchmark(&maze, seed, scaleGames, threads);
+    }
+    else
+    {
+        Output output;
+        openOutput(&output, logPath, verbosity >= 0 ? (Verbosity)verbosity : OUTPUT_FULL, 1);
+        game.sink = outputSink(&output, 0);
+        GameResult result = playGame(&game);
+        if (output.level == OUTPUT_SUMMARY)
+        { // the narration already ends with the winner
+            outputGameEnd(&output, 0, -1, result.winner, result.rounds);
+        }
+        closeOutput(&output);
+    }
 
+    freeDistanceField(&field);
+    freeGame(&game);
+    freeMaze(&maze);
     return 0;
-}
\ No newline at end of file
+}
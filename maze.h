@@ -2,97 +2,85 @@
 #define MAZE_H
 
 #include "helpers.h"
+#include "parse.h"
 
 // ----------------------------------------INITIALIZE MAZE FLOORS----------------------------------------
-void setUpFloors(struct Cell maze[FLOORS][WIDTH][LENGTH]) // --> do not create a copy when passing a array to a function because C passes arrays to functions by reference, not by value.  the compiler treats the function parameter as a pointer to the first element of the original array.
+void setUpFloors(Maze *m) // --> the maze is passed as a pointer so the cells are set up in place, not in a copy
 {
-    // set all cells as empty cells
-    for (int f = 0; f < FLOORS; f++)
+    // set all cells as empty cells, then mark the active areas of every floor
+    for (int c = 0; c < m->noCells; c++)
     {
-        for (int w = 0; w < WIDTH; w++)
+        m->cells[c] = packCell(EMPTY_CELL, -1);
+    }
+    for (int i = 0; i < m->no_Areas; i++)
+    {
+        struct FloorArea a = m->areas[i];
+        for (int w = a.startBlockWidth; w <= a.endBlockWidth; w++)
         {
-            for (int l = 0; l < LENGTH; l++)
+            for (int l = a.startBlockLength; l <= a.endBlockLength; l++)
             {
-                maze[f][w][l].cellType = EMPTY_CELL;
-                maze[f][w][l].cellTypeId = -1;
-                maze[f][w][l].effectType = MP_NONE;
-                maze[f][w][l].effectValue = 0;
+                m->cells[cellIndex(m, (CellCord){a.floor, w, l})] = packCell(ACTIVE_CELL, -1);
             }
         }
     }
 
-    // setup game cells in ground floor
+    // setup the starting area and Bawana in rows 6 to 9 of the ground floor
     int cap = 12;
     int count = 0;
-    bawanaCells = (struct BawanaCell *)malloc(cap * sizeof(struct BawanaCell));
+    m->bawanaCells = (struct BawanaCell *)malloc(cap * sizeof(struct BawanaCell));
+    if (!m->bawanaCells)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
 
-    for (int w = 0; w < WIDTH; w++)
+    for (int w = 6; w < MIN_WIDTH; w++)
     {
-        for (int l = 0; l < LENGTH; l++)
+        for (int l = 8; l < MIN_LENGTH; l++)
         {
-            maze[0][w][l].cellType = ACTIVE_CELL;
-
-            if (w >= 6)
+            if (l <= 16)
             {
-                if (l >= 8 && l <= 16)
-                {
-                    maze[0][w][l].cellType = STARTING_AREA_CELL;
-                }
-                else if (w > 6 && l > 20)
+                m->cells[cellIndex(m, (CellCord){0, w, l})] = packCell(STARTING_AREA_CELL, -1);
+            }
+            else if (w > 6 && l > 20)
+            {
+                if (count >= cap)
                 {
-                    if (count >= cap)
+                    cap *= 2;
+                    m->bawanaCells = (struct BawanaCell *)realloc(m->bawanaCells, cap * sizeof(struct BawanaCell));
+                    if (!m->bawanaCells)
                     {
-                        cap *= 2;
-                        bawanaCells = (struct BawanaCell *)realloc(bawanaCells, cap * sizeof(struct BawanaCell));
-                        if (!bawanaCells)
-                        {
-                            printf("\nError: Memory reallocation failed.\n");
-                            exit(1);
-                        }
+                        printf("\nError: Memory reallocation failed.\n");
+                        exit(1);
                     }
-                    maze[0][w][l].cellType = BAWANA_CELL;
-                    maze[0][w][l].cellTypeId = count;
-                    bawanaCells[count++] = (struct BawanaCell){(CellCord){0, w, l}, RANDOM_CELL, 0};
-                }
-                else if (l >= 20)
-                {
-                    maze[0][w][l].cellType = WALL_CELL;
                 }
+                m->cells[cellIndex(m, (CellCord){0, w, l})] = packCell(BAWANA_CELL, count);
+                m->bawanaCells[count++] = (struct BawanaCell){(CellCord){0, w, l}, RANDOM_CELL, 0};
             }
-        }
-    }
-    no_BawanaCells = count;
-    maze[BawanaEntry.floor][BawanaEntry.width][BawanaEntry.length].cellType = BAWANA_ENTRY; // marking bawana entry
-
-    // setup game cells in first floor
-    for (int w = 0; w < WIDTH; w++)
-    {
-        for (int l = 0; l < LENGTH; l++)
-        {
-            if (w >= 0 && w <= 5)
+            else if (l >= 20)
             {
-                if (l >= 8 && l <= 16)
-                {
-                    continue;
-                }
+                m->cells[cellIndex(m, (CellCord){0, w, l})] = packCell(WALL_CELL, -1);
             }
-            maze[1][w][l].cellType = ACTIVE_CELL;
         }
     }
+    m->no_BawanaCells = count;
+    m->cells[cellIndex(m, BawanaEntry)] = packCell(BAWANA_ENTRY, -1); // marking bawana entry
 
-    // setup game cells in second floor
-    for (int w = 0; w < WIDTH; w++)
+    // on a bigger maze Bawana is no longer against the edges, wall its open sides
+    for (int l = 20; l < MIN_LENGTH && m->width > MIN_WIDTH; l++)
     {
-        for (int l = 8; l <= 16; l++)
-        {
-            maze[2][w][l].cellType = ACTIVE_CELL;
-        }
+        m->cells[cellIndex(m, (CellCord){0, MIN_WIDTH, l})] = packCell(WALL_CELL, -1);
+    }
+    for (int w = 7; w <= MIN_WIDTH && w < m->width && m->length > MIN_LENGTH; w++)
+    {
+        m->cells[cellIndex(m, (CellCord){0, w, MIN_LENGTH})] = packCell(WALL_CELL, -1);
     }
 }
 
 // ----------------------------------------ADD MOVEMENT POINTS TO CELLS----------------------------------------
-void addMovementPointsToCells()
+void addMovementPointsToCells(Maze *m, Rng *rng)
 {
+    PROBE(PROBE_MOVEMENT_POINTS);
     int total = 0;
     int capacity = 100;
     CellCord *activeCellList = (CellCord *)malloc(capacity * sizeof(CellCord));
@@ -103,13 +91,13 @@ void addMovementPointsToCells()
     }
 
     // add all active cells to activeCellList
-    for (int f = 0; f < FLOORS; f++)
+    for (int f = 0; f < m->floors; f++)
     {
-        for (int w = 0; w < WIDTH; w++)
+        for (int w = 0; w < m->width; w++)
         {
-            for (int l = 0; l < LENGTH; l++)
+            for (int l = 0; l < m->length; l++)
             {
-                if (isVacantCell((CellCord){f, w, l}))
+                if (isVacantCell(m, (CellCord){f, w, l}))
                 {
                     if (total >= capacity)
                     {
@@ -137,7 +125,7 @@ void addMovementPointsToCells()
     // shuffle elements in activeCellList
     for (int i = total - 1; i > 0; i--)
     {
-        int j = rand() % (i + 1);
+        int j = (int)rngBelow(rng, i + 1);
         CellCord tmp = activeCellList[i];
         activeCellList[i] = activeCellList[j];
         activeCellList[j] = tmp;
@@ -154,333 +142,952 @@ void addMovementPointsToCells()
     for (int k = 0; k < consumeCells && current_index < total; k++, current_index++)
     {
         CellCord cell = activeCellList[current_index];
-        maze[cell.floor][cell.width][cell.length].effectType = MP_CONSUME;
-        maze[cell.floor][cell.width][cell.length].effectValue = (rand() % 4) + 1;
+        m->cells[cellIndex(m, cell)] = packEffectCell(MP_CONSUME, (int)rngBelow(rng, 4) + 1);
     }
     for (int k = 0; k < bonus1Cells && current_index < total; k++, current_index++)
     {
         CellCord cell = activeCellList[current_index];
-        maze[cell.floor][cell.width][cell.length].effectType = MP_ADD;
-        maze[cell.floor][cell.width][cell.length].effectValue = (rand() % 2) + 1;
+        m->cells[cellIndex(m, cell)] = packEffectCell(MP_ADD, (int)rngBelow(rng, 2) + 1);
     }
     for (int k = 0; k < bonus2Cells && current_index < total; k++, current_index++)
     {
         CellCord cell = activeCellList[current_index];
-        maze[cell.floor][cell.width][cell.length].effectType = MP_ADD;
-        maze[cell.floor][cell.width][cell.length].effectValue = (rand() % 3) + 3;
+        m->cells[cellIndex(m, cell)] = packEffectCell(MP_ADD, (int)rngBelow(rng, 3) + 3);
     }
     for (int k = 0; k < multplyCells && current_index < total; k++, current_index++)
     {
         CellCord cell = activeCellList[current_index];
-        maze[cell.floor][cell.width][cell.length].effectType = MP_MULTIPLY;
-        maze[cell.floor][cell.width][cell.length].effectValue = (rand() % 2) + 2;
+        m->cells[cellIndex(m, cell)] = packEffectCell(MP_MULTIPLY, (int)rngBelow(rng, 2) + 2);
     }
     free(activeCellList);
 }
 
 // ----------------------------------------SET UP BAWANA----------------------------------------
-void bawanaSetUp()
+void bawanaSetUp(Maze *m, Rng *rng)
 {
-    for (int i = 0; i < no_BawanaCells; i++)
+    for (int i = 0; i < m->no_BawanaCells; i++)
     {
         if (i < 2)
         {
-            bawanaCells[i].type = POISONED_CELL;
-            bawanaCells[i].movementPoints = 0;
+            m->bawanaCells[i].type = POISONED_CELL;
+            m->bawanaCells[i].movementPoints = 0;
         }
         else if (i < 4)
         {
-            bawanaCells[i].type = DISORIENTED_CELL;
-            bawanaCells[i].movementPoints = 50;
+            m->bawanaCells[i].type = DISORIENTED_CELL;
+            m->bawanaCells[i].movementPoints = 50;
         }
         else if (i < 6)
         {
-            bawanaCells[i].type = TRIGGERED_CELL;
-            bawanaCells[i].movementPoints = 50;
+            m->bawanaCells[i].type = TRIGGERED_CELL;
+            m->bawanaCells[i].movementPoints = 50;
         }
         else if (i < 8)
         {
-            bawanaCells[i].type = HAPPY_CELL;
-            bawanaCells[i].movementPoints = 200;
+            m->bawanaCells[i].type = HAPPY_CELL;
+            m->bawanaCells[i].movementPoints = 200;
         }
         else
         {
-            bawanaCells[i].type = RANDOM_CELL;
-            bawanaCells[i].movementPoints = rand() % 91 + 10;
+            m->bawanaCells[i].type = RANDOM_CELL;
+            m->bawanaCells[i].movementPoints = (int)rngBelow(rng, 91) + 10;
         }
     }
 }
 
 // ----------------------------------------LOAD FILES----------------------------------------
-void loadSeed()
+unsigned int loadSeed()
 {
     FILE *file = fopen("seed.txt", "r");
-    int seed;
+    int seed = 1;
     if (!file)
     {
         fprintf(stderr, "Error: opening seed.txt... using default value(1) as seed.\n");
-        fflush(stderr);
-        seed = 1;
-        return;
     }
     else
     {
         fscanf(file, "%d", &seed);
+        fclose(file);
     }
-    fclose(file);
-    srand(seed);
+    return (unsigned int)seed;
 }
 
-void loadStairs()
+// footprint of the original three floors, repeated upwards: odd floors are open except for the block above
+// the starting area, even floors are the band of lengths 8 to 16
+void defaultFloorAreas(Maze *m)
 {
-    FILE *file = fopen("stairs.txt", "r");
-    if (!file)
+    m->areas = (struct FloorArea *)malloc(3 * m->floors * sizeof(struct FloorArea));
+    if (!m->areas)
     {
-        printf("Error: Could not open stairs.txt\n");
+        printf("\nError: Memory allocation failed.\n");
         exit(1);
     }
+    int count = 0;
+    m->areas[count++] = (struct FloorArea){0, 0, 0, m->width - 1, m->length - 1};
+    for (int f = 1; f < m->floors; f++)
+    {
+        if (f % 2 == 1)
+        {
+            m->areas[count++] = (struct FloorArea){f, 0, 0, 5, 7};
+            m->areas[count++] = (struct FloorArea){f, 0, 17, 5, m->length - 1};
+            m->areas[count++] = (struct FloorArea){f, 6, 0, m->width - 1, m->length - 1};
+        }
+        else
+        {
+            m->areas[count++] = (struct FloorArea){f, 0, 8, m->width - 1, 16};
+        }
+    }
+    m->no_Areas = count;
+}
 
-    struct Stair tempStair;
-    int line = 0, validCount = 0;
+bool isValidFloorArea(const Maze *m, struct FloorArea a, int line, bool logError)
+{
+    if (!isValidFloor(m, a.floor) ||
+        !isValidWidth(m, a.startBlockWidth) || !isValidWidth(m, a.endBlockWidth) ||
+        !isValidLength(m, a.startBlockLength) || !isValidLength(m, a.endBlockLength) ||
+        a.startBlockWidth > a.endBlockWidth || a.startBlockLength > a.endBlockLength)
+    {
+        if (logError)
+        {
+            fprintf(stderr, "Line %d of maze.txt: Floor area is out of bounds or reversed.\n", line);
+        }
+        return false;
+    }
+    return true;
+}
 
-    // count valid stairs
-    while (1)
+// maze size and floor areas: "[floors, width, length]" then one "[floor, startWidth, startLength, endWidth, endLength]"
+// per area. without the file, or without areas, the maze is the default one
+void loadMazeSize(Maze *m)
+{
+    *m = (Maze){0}; // a text maze starts empty, freeMaze tells it from a mapped snapshot by its snapshot field
+    m->floors = DEFAULT_FLOORS;
+    m->width = DEFAULT_WIDTH;
+    m->length = DEFAULT_LENGTH;
+
+    EntryList entries;
+    int size[3];
+    int sizeRead = readEntryFile(&entries, "maze.txt", 5, size, 3);
+    if (sizeRead == EOF)
     {
-        int values = fscanf(file, " [%d, %d, %d, %d, %d, %d] ",
-                            &tempStair.startFloor,
-                            &tempStair.startBlockWidth,
-                            &tempStair.startBlockLength,
-                            &tempStair.endFloor,
-                            &tempStair.endBlockWidth,
-                            &tempStair.endBlockLength);
+        defaultFloorAreas(m);
+        return;
+    }
 
-        if (values == EOF)
+    if (sizeRead != 3)
+    {
+        printf("\nError: maze.txt must start with [floors, width, length].\n");
+        exit(1);
+    }
+    m->floors = size[0];
+    m->width = size[1];
+    m->length = size[2];
+    if (m->floors < 1 || m->width < MIN_WIDTH || m->length < MIN_LENGTH ||
+        (long long)m->floors * m->width * m->length > 0x7FFFFFFF)
+    {
+        printf("\nError: maze size in maze.txt must be at least 1 x %d x %d and fit in an int.\n", MIN_WIDTH, MIN_LENGTH);
+        exit(1);
+    }
+
+    int count = 0;
+    m->areas = (struct FloorArea *)malloc((entries.count + 1) * sizeof(struct FloorArea));
+    if (!m->areas)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int i = 0; i < entries.count; i++)
+    {
+        const int *v = entries.values + i * 5;
+        struct FloorArea area = {v[0], v[1], v[2], v[3], v[4]};
+        if (isValidFloorArea(m, area, entries.lines[i], true))
         {
-            break;
+            m->areas[count++] = area;
         }
+    }
+    freeEntryList(&entries);
+
+    if (count == 0)
+    {
+        free(m->areas);
+        defaultFloorAreas(m);
+        return;
+    }
+    m->no_Areas = count;
+}
+
+// ----------------------------------------WALL CONNECTIVITY----------------------------------------
+// a wall is kept unless it cuts the starting area or BawanaEntry off the flag, over the floors and the stairs and
+// poles between them, read before the walls load. placing a straight run of walkable cells cuts a piece of its floor
+// in two exactly when it closes a loop of blocked cells, so it is enough to look at the blocked cells around the run
+// and whether two of them were already joined. a run that cuts can only part the flag from the others if it blocks a
+// cell of the last paths found between them, and only then a search from the flag goes over the whole maze
+
+void freeBlockedSets(Maze *m)
+{
+    free(m->blocked.parent);
+    free(m->blocked.size);
+    free(m->blocked.undo);
+    free(m->blocked.linkHead);
+    free(m->blocked.linkNext);
+    free(m->blocked.linkTo);
+    free(m->blocked.flood);
+    free(m->blocked.queue);
+    free(m->blocked.from);
+    free(m->blocked.onPath);
+    free(m->blocked.path);
+    m->blocked = (BlockedSets){0};
+}
 
-        line++;
+int findBlockedSet(const BlockedSets *s, int x)
+{
+    while (s->parent[x] != x)
+    {
+        x = s->parent[x];
+    }
+    return x;
+}
 
-        if (values != 6)
+void uniteBlockedSets(BlockedSets *s, int a, int b)
+{
+    a = findBlockedSet(s, a);
+    b = findBlockedSet(s, b);
+    if (a == b)
+    {
+        return;
+    }
+    if (s->size[a] < s->size[b])
+    {
+        int t = a;
+        a = b;
+        b = t;
+    }
+    s->parent[b] = a;
+    s->size[a] += s->size[b];
+    s->undo[s->no_Undo++] = b;
+}
+
+// undo the unions and blocked cells back to mark
+void undoBlockedSets(BlockedSets *s, int mark)
+{
+    while (s->no_Undo > mark)
+    {
+        int x = s->undo[--s->no_Undo];
+        if (x < 0)
         {
-            fprintf(stderr, "Line %d of stairs.txt: Malformed input (expected 6 integers)\n", line);
-            fflush(stderr);
-            continue;
+            s->parent[~x] = -1;
         }
-
-        if (isValidStair(tempStair, line, true))
+        else
         {
-            validCount++;
+            s->size[s->parent[x]] -= s->size[x];
+            s->parent[x] = x;
         }
     }
+}
 
-    if (validCount == 0)
+// a stair or a floor of a pole, either way as the stairs flip. the arrays hold every link linkObjectEnds counted
+void linkBlockedCells(Maze *m, CellCord a, CellCord b)
+{
+    BlockedSets *s = &m->blocked;
+    if (!isValidCordinates(m, a) || !isValidCordinates(m, b))
     {
-        printf("Error: No valid stairs found in stairs.txt. Quitting Game....\n");
-        fclose(file);
-        exit(1);
+        return;
     }
+    int ends[2] = {cellIndex(m, a), cellIndex(m, b)};
+    for (int k = 0; k < 2; k++)
+    {
+        s->linkTo[s->no_Links] = ends[1 - k];
+        s->linkNext[s->no_Links] = s->linkHead[ends[k]];
+        s->linkHead[ends[k]] = s->no_Links++;
+    }
+}
 
-    // Allocate exact memory
-    stairs = malloc(validCount * sizeof(struct Stair));
-    if (!stairs)
+void initBlockedSets(Maze *m)
+{
+    BlockedSets *s = &m->blocked;
+    int sets = m->noCells + m->floors;
+    s->parent = (int *)malloc(sets * sizeof(int));
+    s->size = (int *)malloc(sets * sizeof(int));
+    s->undo = (int *)malloc(2 * sets * sizeof(int)); // a wall blocks at most every cell and unites at most every set
+    s->linkHead = (int *)malloc(m->noCells * sizeof(int));
+    s->flood = (int *)malloc(m->noCells * sizeof(int));
+    s->queue = (int *)malloc(m->noCells * sizeof(int));
+    s->from = (int *)malloc(m->noCells * sizeof(int));
+    s->onPath = (unsigned char *)calloc(m->noCells, 1);
+    s->path = (int *)malloc(m->noCells * sizeof(int));
+    if (!s->parent || !s->size || !s->undo || !s->linkHead || !s->flood || !s->queue || !s->from || !s->onPath || !s->path)
     {
-        printf("Error: Memory allocation failed.\n");
-        fclose(file);
+        printf("\nError: Memory allocation failed.\n");
         exit(1);
     }
+    s->no_Undo = 0;
+    for (int c = 0; c < sets; c++)
+    {
+        s->parent[c] = c >= m->noCells || isBlockedCell(m, cellFromIndex(m, c)) ? c : -1;
+        s->size[c] = 1;
+    }
+    for (int c = 0; c < m->noCells; c++)
+    {
+        if (s->parent[c] < 0)
+        {
+            continue;
+        }
+        CellCord cell = cellFromIndex(m, c);
+        for (int dw = -1; dw <= 1; dw++)
+        {
+            for (int dl = -1; dl <= 1; dl++)
+            {
+                int w = cell.width + dw, l = cell.length + dl;
+                if (!isValidWidth(m, w) || !isValidLength(m, l))
+                {
+                    uniteBlockedSets(s, c, m->noCells + cell.floor);
+                }
+                else if (s->parent[cellIndex(m, (CellCord){cell.floor, w, l})] >= 0)
+                {
+                    uniteBlockedSets(s, c, cellIndex(m, (CellCord){cell.floor, w, l}));
+                }
+            }
+        }
+    }
+    s->no_Undo = 0; // the blocked cells of the floors are never undone
 
-    // load valid stairs
-    rewind(file);
-    int count = 0;
-    line = 0;
+    s->linkNext = s->linkTo = NULL;
+    s->no_Links = 0;
+    s->floodStamp = 0;
+    s->no_Path = -1;
+    for (int c = 0; c < m->noCells; c++)
+    {
+        s->linkHead[c] = -1;
+        s->flood[c] = -1;
+    }
+}
 
-    while (1)
+// link the ends of every stair and the floors of every pole of the entries, once before the walls. the entries are
+// taken as they are, one the loaders throw out later only keeps more walls out. either list may be NULL
+void linkObjectEnds(Maze *m, const EntryList *stairs, const EntryList *poles)
+{
+    BlockedSets *s = &m->blocked;
+    long links = stairs ? stairs->count : 0;
+    for (int i = 0; poles && i < poles->count; i++)
     {
-        int values = fscanf(file, " [%d, %d, %d, %d, %d, %d] ",
-                            &tempStair.startFloor,
-                            &tempStair.startBlockWidth,
-                            &tempStair.startBlockLength,
-                            &tempStair.endFloor,
-                            &tempStair.endBlockWidth,
-                            &tempStair.endBlockLength);
+        const int *v = poles->values + i * 4;
+        links += v[1] > v[0] && v[0] >= 0 && v[1] < m->floors ? v[1] - v[0] : 0;
+    }
+    s->linkNext = (int *)realloc(s->linkNext, (2 * links + 1) * sizeof(int));
+    s->linkTo = (int *)realloc(s->linkTo, (2 * links + 1) * sizeof(int));
+    if (!s->linkNext || !s->linkTo)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    s->no_Links = 0;
+    for (int c = 0; c < m->noCells; c++)
+    {
+        s->linkHead[c] = -1;
+    }
 
-        if (values == EOF)
+    for (int i = 0; stairs && i < stairs->count; i++)
+    {
+        const int *v = stairs->values + i * 6;
+        linkBlockedCells(m, (CellCord){v[0], v[1], v[2]}, (CellCord){v[3], v[4], v[5]});
+    }
+    for (int i = 0; poles && i < poles->count; i++)
+    {
+        const int *v = poles->values + i * 4;
+        for (int f = v[0]; v[1] > v[0] && v[0] >= 0 && v[1] < m->floors && f < v[1]; f++)
         {
-            break;
+            linkBlockedCells(m, (CellCord){f, v[2], v[3]}, (CellCord){f + 1, v[2], v[3]});
         }
-        line++;
+    }
+}
+
+// set of a cell around a wall: the outside set beyond the maze, -1 if the cell is walkable
+int blockedSetAt(const Maze *m, int f, int w, int l)
+{
+    if (!isValidWidth(m, w) || !isValidLength(m, l))
+    {
+        return findBlockedSet(&m->blocked, m->noCells + f);
+    }
+    int c = cellIndex(m, (CellCord){f, w, l});
+    return m->blocked.parent[c] < 0 ? -1 : findBlockedSet(&m->blocked, c);
+}
 
-        if (values != 6)
+void blockCell(Maze *m, int f, int w, int l)
+{
+    BlockedSets *s = &m->blocked;
+    int c = cellIndex(m, (CellCord){f, w, l});
+    s->parent[c] = c;
+    s->size[c] = 1;
+    s->undo[s->no_Undo++] = ~c;
+    for (int dw = -1; dw <= 1; dw++)
+    {
+        for (int dl = -1; dl <= 1; dl++)
         {
-            continue;
+            if (!isValidWidth(m, w + dw) || !isValidLength(m, l + dl))
+            {
+                uniteBlockedSets(s, c, m->noCells + f);
+            }
+            else if (s->parent[cellIndex(m, (CellCord){f, w + dw, l + dl})] >= 0)
+            {
+                uniteBlockedSets(s, c, cellIndex(m, (CellCord){f, w + dw, l + dl}));
+            }
         }
+    }
+}
 
-        if (!isValidStair(tempStair, line, false))
+int compareInts(const void *a, const void *b) { return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b); }
+
+// would blocking the walkable cells [w0..w1] x [l0..l1] of floor f, one row or column, cut a piece of the floor in two.
+// the ring of cells around the run is walked in order: each stretch of blocked cells between two walkable cells
+// touching the run belongs to one set. the corners only touch the run diagonally and do not end a stretch
+bool cutsFloor(const Maze *m, int f, int w0, int l0, int w1, int l1, int *ring, int *sets)
+{
+    int n = 0;
+    for (int l = l0 - 1; l <= l1 + 1; l++)
+    {
+        ring[n++] = blockedSetAt(m, f, w0 - 1, l);
+    }
+    for (int w = w0; w <= w1; w++)
+    {
+        ring[n++] = blockedSetAt(m, f, w, l1 + 1);
+    }
+    for (int l = l1 + 1; l >= l0 - 1; l--)
+    {
+        ring[n++] = blockedSetAt(m, f, w1 + 1, l);
+    }
+    for (int w = w1; w >= w0; w--)
+    {
+        ring[n++] = blockedSetAt(m, f, w, l0 - 1);
+    }
+    int side = l1 - l0 + 3;
+    int corners[4] = {0, side - 1, side + w1 - w0 + 1, 2 * side + w1 - w0};
+    for (int k = 0; k < 4; k++)
+    {
+        ring[corners[k]] = ring[corners[k]] < 0 ? -2 : ring[corners[k]];
+    }
+
+    int start = 0;
+    while (start < n && ring[start] != -1)
+    {
+        start++;
+    }
+    if (start == n)
+    {
+        return false; // nothing walkable touches the run, there is nothing to cut
+    }
+    int count = 0, stretch = -1;
+    for (int k = 1; k <= n; k++)
+    {
+        int set = ring[(start + k) % n];
+        if (set >= 0)
         {
-            continue;
+            stretch = set;
+        }
+        else if (set == -1 && stretch >= 0)
+        {
+            sets[count++] = stretch;
+            stretch = -1;
         }
-
-        tempStair.stairId = count;
-        tempStair.dir = BI_DIR;
-        stairs[count++] = tempStair;
     }
 
-    fclose(file);
-    no_Stairs = count;
+    qsort(sets, count, sizeof(int), compareInts);
+    for (int k = 1; k < count; k++)
+    {
+        if (sets[k] == sets[k - 1])
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
-void loadPoles()
+// queue a walkable cell the search with the stamp has not reached yet, coming from the cell from
+void floodBlockedCell(BlockedSets *s, int c, int from, int stamp, int *tail)
 {
-    FILE *file = fopen("poles.txt", "r");
-    if (!file)
+    if (s->parent[c] < 0 && s->flood[c] != stamp)
     {
-        printf("Error: Could not open poles.txt\n");
-        exit(1);
+        s->flood[c] = stamp;
+        s->from[c] = from;
+        s->queue[(*tail)++] = c;
     }
+}
 
-    struct Pole tempPole;
-    int line = 0, validCount = 0;
+// a run that did not cut blocked a cell of the last paths, so the next run that cuts searches again
+void forgetFlagPath(BlockedSets *s)
+{
+    for (int k = 0; k < s->no_Path; k++)
+    {
+        s->onPath[s->path[k]] = 0;
+    }
+    s->no_Path = -1;
+}
 
-    // count valid poles
-    while (1)
+// mark the cells from c back to the flag along the search that reached it
+void markFlagPath(BlockedSets *s, int c)
+{
+    for (; c >= 0 && !s->onPath[c]; c = s->from[c])
     {
-        int values = fscanf(file, " [%d, %d, %d, %d] ",
-                            &tempPole.startFloor,
-                            &tempPole.endFloor,
-                            &tempPole.widthCell,
-                            &tempPole.lengthCell);
+        s->onPath[c] = 1;
+        s->path[s->no_Path++] = c;
+    }
+}
 
-        if (values == EOF)
+// whether the starting area and BawanaEntry can still be reached from the flag, walking the floors and taking the
+// stairs and poles either way. the search stops once both are found, and the paths to them replace the last ones
+bool isFlagJoined(Maze *m)
+{
+    BlockedSets *s = &m->blocked;
+    int entry = cellIndex(m, BawanaEntry);
+    int stamp = s->floodStamp++, head = 0, tail = 0, start = -1;
+    bool bawana = false;
+    floodBlockedCell(s, cellIndex(m, m->Flag), -1, stamp, &tail);
+    while (head < tail && !(start >= 0 && bawana))
+    {
+        int c = s->queue[head++];
+        start = start < 0 && cellTypeOf(m->cells[c]) == STARTING_AREA_CELL ? c : start;
+        bawana |= c == entry;
+        for (int link = s->linkHead[c]; link >= 0; link = s->linkNext[link])
         {
-            break;
+            floodBlockedCell(s, s->linkTo[link], c, stamp, &tail);
         }
+        CellCord cell = cellFromIndex(m, c);
+        for (Direction d = NORTH; d <= WEST; d++)
+        {
+            CellCord next = getNextCellCoord(cell, d);
+            if (isValidCordinates(m, next))
+            {
+                floodBlockedCell(s, cellIndex(m, next), c, stamp, &tail);
+            }
+        }
+    }
+    if (start < 0 || !bawana)
+    {
+        return false;
+    }
+    forgetFlagPath(s);
+    s->no_Path = 0;
+    markFlagPath(s, start);
+    markFlagPath(s, entry);
+    return true;
+}
 
-        line++;
+// block the cells of a wall unless that cuts the starts off the flag, the parts of it on cells already blocked are
+// skipped. the walls are checked once every wall before them is in the sets
+bool keepsFlagJoined(Maze *m, struct Wall wall, int line, bool logError)
+{
+    bool horizontal = wall.startBlockWidth == wall.endBlockWidth;
+    int w0 = wall.startBlockWidth < wall.endBlockWidth ? wall.startBlockWidth : wall.endBlockWidth;
+    int l0 = wall.startBlockLength < wall.endBlockLength ? wall.startBlockLength : wall.endBlockLength;
+    int count = horizontal ? abs(wall.startBlockLength - wall.endBlockLength) + 1
+                           : abs(wall.startBlockWidth - wall.endBlockWidth) + 1;
+    int *ring = (int *)malloc(2 * (2 * count + 6) * sizeof(int));
+    if (!ring)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
 
-        if (values != 4)
+    int mark = m->blocked.no_Undo;
+    bool cuts = false;
+    for (int i = 0; i < count && !cuts; i++)
+    {
+        int run = 0; // walkable cells from i on, they are checked and blocked together
+        while (i + run < count &&
+               m->blocked.parent[cellIndex(m, (CellCord){wall.floor, horizontal ? w0 : w0 + i + run, horizontal ? l0 + i + run : l0})] < 0)
+        {
+            run++;
+        }
+        if (run == 0)
         {
             continue;
         }
+        int w1 = horizontal ? w0 : w0 + i + run - 1;
+        int l1 = horizontal ? l0 + i + run - 1 : l0;
+        bool cut = cutsFloor(m, wall.floor, horizontal ? w0 : w0 + i, horizontal ? l0 + i : l0, w1, l1, ring, ring + 2 * count + 6);
+        for (int k = 0; k < run; k++)
+        {
+            blockCell(m, wall.floor, horizontal ? w0 : w0 + i + k, horizontal ? l0 + i + k : l0);
+        }
+        bool onPath = m->blocked.no_Path < 0;
+        for (int k = 0; k < run; k++)
+        {
+            onPath |= m->blocked.onPath[cellIndex(m, (CellCord){wall.floor, horizontal ? w0 : w0 + i + k, horizontal ? l0 + i + k : l0})];
+        }
+        if (onPath && cut)
+        {
+            cuts = !isFlagJoined(m);
+        }
+        else if (onPath)
+        {
+            forgetFlagPath(&m->blocked);
+        }
+        i += run - 1;
+    }
+    free(ring);
 
-        if (isValidPole(tempPole, line, false))
+    if (cuts)
+    {
+        undoBlockedSets(&m->blocked, mark);
+        if (logError)
         {
-            validCount++;
+            fprintf(stderr, "Line %d of walls.txt: Wall on floor %d would cut the starting area or Bawana off the flag.\n", line, wall.floor);
         }
+        return false;
     }
+    m->blocked.no_Undo = 0; // the wall is kept, its unions are final
+    return true;
+}
+
+// ----------------------------------------OCCUPANCY INDEX----------------------------------------
+// while the objects load, every cell remembers the object holding it and the line it came from. an object is
+// checked against all objects before it as it is read, so validation stays linear in the cells the objects cover
+
+#define OWNER_KIND_BITS 3
 
-    if (validCount == 0)
+const char *ownerNames[] = {"", "special cell", "flag", "wall", "stair", "pole"};
+
+const char *ownerFiles[] = {"", "", "", "walls.txt", "stairs.txt", "poles.txt"};
+
+uint32_t packOwner(OwnerKind kind, int line) { return (uint32_t)line << OWNER_KIND_BITS | kind; }
+
+// hold the special cells and the flag, which are placed before any object
+void initOccupancy(Maze *m)
+{
+    m->owner = (uint32_t *)calloc(m->noCells, sizeof(uint32_t));
+    if (!m->owner)
     {
-        printf("Error: No valid poles found in poles.txt. Quitting Game....\n");
-        fclose(file);
+        printf("\nError: Memory allocation failed.\n");
         exit(1);
     }
+    for (int i = 0; i < (int)(sizeof(specialCells) / sizeof(specialCells[0])); i++)
+    {
+        if (isValidCordinates(m, specialCells[i]))
+        {
+            m->owner[cellIndex(m, specialCells[i])] = packOwner(SPECIAL_OWNER, 0);
+        }
+    }
+    m->owner[cellIndex(m, m->Flag)] = packOwner(FLAG_OWNER, 0);
+}
 
-    // Allocate exact memory
-    poles = malloc(validCount * sizeof(struct Pole));
-    if (!poles)
+void freeOccupancy(Maze *m)
+{
+    free(m->owner);
+    m->owner = NULL;
+}
+
+// check count cells from start, step apart, are not held by another object. walls may cross walls
+bool isSpanFree(const Maze *m, CellCord start, CellCord step, int count, OwnerKind kind, int line, bool logError)
+{
+    CellCord cell = start;
+    for (int i = 0; i < count; i++)
     {
-        printf("Error: Memory allocation failed.\n");
-        fclose(file);
-        exit(1);
+        uint32_t owner = m->owner[cellIndex(m, cell)];
+        OwnerKind other = (OwnerKind)(owner & ((1 << OWNER_KIND_BITS) - 1));
+        if (other != NO_OWNER && !(other == WALL_OWNER && kind == WALL_OWNER))
+        {
+            if (logError && ownerFiles[other][0])
+            {
+                fprintf(stderr, "Line %d of %s: Overlaps the %s on line %d of %s at [%d,%d,%d].\n", line, ownerFiles[kind],
+                        ownerNames[other], owner >> OWNER_KIND_BITS, ownerFiles[other], cell.floor, cell.width, cell.length);
+            }
+            else if (logError)
+            {
+                fprintf(stderr, "Line %d of %s: Overlaps the %s at [%d,%d,%d].\n", line, ownerFiles[kind],
+                        ownerNames[other], cell.floor, cell.width, cell.length);
+            }
+            return false;
+        }
+        cell = (CellCord){cell.floor + step.floor, cell.width + step.width, cell.length + step.length};
     }
+    return true;
+}
 
-    // load valid poles
-    rewind(file);
-    int count = 0;
-    line = 0;
+void claimSpan(Maze *m, CellCord start, CellCord step, int count, OwnerKind kind, int line)
+{
+    CellCord cell = start;
+    for (int i = 0; i < count; i++)
+    {
+        int c = cellIndex(m, cell);
+        m->owner[c] = m->owner[c] ? m->owner[c] : packOwner(kind, line);
+        cell = (CellCord){cell.floor + step.floor, cell.width + step.width, cell.length + step.length};
+    }
+}
+
+// the claims hold the cells of an object unless it overlaps another one. without an index they always succeed
+bool claimWall(Maze *m, struct Wall wall, int line)
+{
+    if (!m->owner)
+    {
+        return true;
+    }
+    bool horizontal = wall.startBlockWidth == wall.endBlockWidth;
+    CellCord start = {wall.floor,
+                      wall.startBlockWidth < wall.endBlockWidth ? wall.startBlockWidth : wall.endBlockWidth,
+                      wall.startBlockLength < wall.endBlockLength ? wall.startBlockLength : wall.endBlockLength};
+    CellCord step = horizontal ? (CellCord){0, 0, 1} : (CellCord){0, 1, 0};
+    int count = horizontal ? abs(wall.startBlockLength - wall.endBlockLength) + 1
+                           : abs(wall.startBlockWidth - wall.endBlockWidth) + 1;
+    if (!isSpanFree(m, start, step, count, WALL_OWNER, line, true) ||
+        (m->blocked.parent && !keepsFlagJoined(m, wall, line, true)))
+    {
+        return false;
+    }
+    claimSpan(m, start, step, count, WALL_OWNER, line);
+    return true;
+}
 
-    while (1)
+bool claimStair(Maze *m, struct Stair stair, int line)
+{
+    if (!m->owner)
+    {
+        return true;
+    }
+    CellCord start = {stair.startFloor, stair.startBlockWidth, stair.startBlockLength};
+    CellCord end = {stair.endFloor, stair.endBlockWidth, stair.endBlockLength};
+    CellCord none = {0, 0, 0};
+    if (!isSpanFree(m, start, none, 1, STAIR_OWNER, line, true) || !isSpanFree(m, end, none, 1, STAIR_OWNER, line, true))
     {
-        int values = fscanf(file, " [%d, %d, %d, %d] ",
-                            &tempPole.startFloor,
-                            &tempPole.endFloor,
-                            &tempPole.widthCell,
-                            &tempPole.lengthCell);
+        return false;
+    }
+    claimSpan(m, start, none, 1, STAIR_OWNER, line);
+    claimSpan(m, end, none, 1, STAIR_OWNER, line);
+    return true;
+}
 
-        if (values == EOF)
+bool claimPole(Maze *m, struct Pole pole, int line)
+{
+    if (!m->owner)
+    {
+        return true;
+    }
+    CellCord start = {pole.startFloor, pole.widthCell, pole.lengthCell};
+    CellCord up = {1, 0, 0};
+    int count = pole.endFloor - pole.startFloor + 1;
+    if (!isSpanFree(m, start, up, count, POLE_OWNER, line, true))
+    {
+        return false;
+    }
+    claimSpan(m, start, up, count, POLE_OWNER, line);
+    return true;
+}
+
+// the objects of an entry list that pass their rules and do not overlap the ones laid before them, the arrays are
+// allocated once for every entry. returns the number laid
+int layStairs(Maze *m, const EntryList *e)
+{
+    m->stairs = (struct Stair *)malloc((e->count + 1) * sizeof(struct Stair));
+    if (!m->stairs)
+    {
+        printf("Error: Memory allocation failed.\n");
+        exit(1);
+    }
+    int count = 0;
+    for (int i = 0; i < e->count; i++)
+    {
+        const int *v = e->values + i * 6;
+        struct Stair tempStair = {count, v[0], v[1], v[2], v[3], v[4], v[5]};
+        if (!isValidStair(m, tempStair, e->lines[i], true) || !claimStair(m, tempStair, e->lines[i]))
         {
-            break;
+            continue;
         }
+        m->stairs[count++] = tempStair;
+    }
+    m->no_Stairs = count;
+    return count;
+}
 
-        line++;
-
-        if (values != 4)
+int layPoles(Maze *m, const EntryList *e)
+{
+    m->poles = (struct Pole *)malloc((e->count + 1) * sizeof(struct Pole));
+    if (!m->poles)
+    {
+        printf("Error: Memory allocation failed.\n");
+        exit(1);
+    }
+    int count = 0;
+    for (int i = 0; i < e->count; i++)
+    {
+        const int *v = e->values + i * 4;
+        struct Pole tempPole = {count, v[0], v[1], v[2], v[3]};
+        if (!isValidPole(m, tempPole, e->lines[i], true) || !claimPole(m, tempPole, e->lines[i]))
         {
-            fprintf(stderr, "Line %d of poles.txt: Malformed input (expected 4 integers)\n", line);
-            fflush(stderr);
             continue;
         }
+        m->poles[count++] = tempPole;
+    }
+    m->no_Poles = count;
+    return count;
+}
 
-        if (!isValidPole(tempPole, line, true))
+int layWalls(Maze *m, const EntryList *e)
+{
+    m->walls = (struct Wall *)malloc((e->count + 1) * sizeof(struct Wall));
+    if (!m->walls)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    int count = 0;
+    for (int i = 0; i < e->count; i++)
+    {
+        const int *v = e->values + i * 5;
+        struct Wall tempWall = {v[0], v[1], v[2], v[3], v[4]};
+        if (!isValidWall(m, tempWall, e->lines[i], true) || !claimWall(m, tempWall, e->lines[i]))
         {
             continue;
         }
+        m->walls[count++] = tempWall;
+    }
+    m->no_Walls = count;
+    return count;
+}
+
+// the object loaders map their file, read its entries in one pass and lay them. the stairs and poles can be read
+// apart from being laid, so the walls loaded in between know their ends
+void readStairsFile(EntryList *entries, const char *path)
+{
+    if (!readEntryList(entries, path, 6))
+    {
+        printf("Error: Could not open %s\n", path);
+        exit(1);
+    }
+}
 
-        tempPole.poleId = count;
-        poles[count++] = tempPole;
+void readPolesFile(EntryList *entries, const char *path)
+{
+    if (!readEntryList(entries, path, 4))
+    {
+        printf("Error: Could not open %s\n", path);
+        exit(1);
     }
+}
 
-    fclose(file);
-    no_Poles = count;
+// lay the entries read from path and free them
+void layStairsFile(Maze *m, EntryList *entries, const char *path)
+{
+    PROBE(PROBE_LOAD_STAIRS);
+    int count = layStairs(m, entries);
+    freeEntryList(entries);
+    if (count == 0)
+    {
+        printf("Error: No valid stairs found in %s. Quitting Game....\n", path);
+        exit(1);
+    }
 }
 
-void loadWalls()
+void layPolesFile(Maze *m, EntryList *entries, const char *path)
 {
-    FILE *file = fopen("walls.txt", "r");
-    if (!file)
+    PROBE(PROBE_LOAD_POLES);
+    int count = layPoles(m, entries);
+    freeEntryList(entries);
+    if (count == 0)
     {
-        printf("\nError: opening walls.txt\n");
+        printf("Error: No valid poles found in %s. Quitting Game....\n", path);
         exit(1);
     }
+}
 
-    int capacity = 10;
-    int count = 0;
-    walls = (struct Wall *)malloc(capacity * sizeof(struct Wall));
-    if (!walls)
+void loadStairsFile(Maze *m, const char *path)
+{
+    EntryList entries;
+    readStairsFile(&entries, path);
+    layStairsFile(m, &entries, path);
+}
+
+void loadPolesFile(Maze *m, const char *path)
+{
+    EntryList entries;
+    readPolesFile(&entries, path);
+    layPolesFile(m, &entries, path);
+}
+
+void loadWallsFile(Maze *m, const char *path)
+{
+    PROBE(PROBE_LOAD_WALLS);
+    EntryList entries;
+    if (!readEntryList(&entries, path, 5))
     {
-        printf("\nError: Memory allocation failed.\n");
-        fclose(file);
+        printf("\nError: opening %s\n", path);
+        exit(1);
+    }
+    int count = layWalls(m, &entries);
+    freeEntryList(&entries);
+    if (count == 0)
+    {
+        printf("\nError: No valid walls were loaded from the file. Quitting Game....\n");
         exit(1);
     }
+}
+
+void loadStairs(Maze *m) { loadStairsFile(m, "stairs.txt"); }
+
+void loadPoles(Maze *m) { loadPolesFile(m, "poles.txt"); }
+
+void loadWalls(Maze *m) { loadWallsFile(m, "walls.txt"); }
 
-    struct Wall tempWall;
-    int line = 0;
-    while (fscanf(file, " [%d, %d, %d, %d, %d] ",
-                  &tempWall.floor,
-                  &tempWall.startBlockWidth,
-                  &tempWall.startBlockLength,
-                  &tempWall.endBlockWidth,
-                  &tempWall.endBlockLength) == 5)
+// ----------------------------------------FSCANF REFERENCE----------------------------------------
+// the old two pass stair loader, kept to time and cross check the mapped one. it does not log
+void loadStairsScanf(Maze *m, const char *path)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
     {
-        line++;
-        if (!isValidWall(tempWall, line, true))
+        printf("Error: Could not open %s\n", path);
+        exit(1);
+    }
+
+    struct Stair tempStair;
+    int validCount = 0;
+    for (int pass = 0; pass < 2; pass++) // count the valid stairs, then load them
+    {
+        int count = 0;
+        while (1)
         {
-            continue;
+            int values = fscanf(file, " [%d, %d, %d, %d, %d, %d] ",
+                                &tempStair.startFloor,
+                                &tempStair.startBlockWidth,
+                                &tempStair.startBlockLength,
+                                &tempStair.endFloor,
+                                &tempStair.endBlockWidth,
+                                &tempStair.endBlockLength);
+            if (values != 6)
+            {
+                break;
+            }
+            if (!isValidStair(m, tempStair, 0, false))
+            {
+                continue;
+            }
+            if (pass == 1)
+            {
+                tempStair.stairId = count;
+                m->stairs[count] = tempStair;
+            }
+            count++;
         }
-        walls[count++] = tempWall;
-        if (count >= capacity)
+        if (pass == 0)
         {
-            capacity *= 2;
-            walls = (struct Wall *)realloc(walls, capacity * sizeof(struct Wall));
-            if (!walls)
+            validCount = count;
+            m->stairs = (struct Stair *)malloc((validCount + 1) * sizeof(struct Stair));
+            if (!m->stairs)
             {
-                printf("\nError: Memory reallocation failed.\n");
-                fclose(file);
+                printf("Error: Memory allocation failed.\n");
                 exit(1);
             }
+            rewind(file);
         }
     }
     fclose(file);
-    if (count == 0)
-    {
-        printf("\nError: No valid walls were loaded from the file. Quitting Game....\n");
-        exit(1);
-    }
-    no_Walls = count;
+    m->no_Stairs = validCount;
 }
 
-void loadFlag()
+// the flag position of a "[floor, width, length]" file, false if it is not in that form
+bool readFlag(FILE *file, CellCord *flag)
+{
+    return fscanf(file, " [%d, %d, %d] ", &flag->floor, &flag->width, &flag->length) == 3;
+}
+
+void loadFlag(Maze *m)
 {
     FILE *file = fopen("flag.txt", "r");
     if (!file)
@@ -490,63 +1097,70 @@ void loadFlag()
     }
 
     CellCord flagPosition;
-    if (fscanf(file, " [%d, %d, %d] ", &flagPosition.floor, &flagPosition.width, &flagPosition.length) != 3)
+    if (!readFlag(file, &flagPosition))
     {
         printf("\nError: Invalid flag format in flag.txt\n");
         fclose(file);
         exit(1);
     }
 
-    if (!isVacantCell(flagPosition))
+    if (!isVacantCell(m, flagPosition))
     {
         printf("\nError: Invalid flag location. Quitting Game....\n");
         fclose(file);
         exit(1);
     }
 
-    Flag = flagPosition;
+    m->Flag = flagPosition;
     fclose(file);
 }
 
 // ----------------------------------------ADD OBJECTS TO MAZE----------------------------------------
-void addStairsToMaze()
+void addStairsToMaze(Maze *m)
 {
-    for (int i = 0; i < no_Stairs; i++)
+    if (m->no_Stairs > MAX_CELL_ID + 1) // ids must fit in a packed cell
     {
-        struct Stair tempStair = stairs[i];
-        maze[tempStair.startFloor][tempStair.startBlockWidth][tempStair.startBlockLength].cellType = STAIR_CELL;
-        maze[tempStair.startFloor][tempStair.startBlockWidth][tempStair.startBlockLength].cellTypeId = tempStair.stairId;
+        printf("\nError: Too many stairs, at most %d are supported.\n", MAX_CELL_ID + 1);
+        exit(1);
+    }
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        struct Stair tempStair = m->stairs[i];
+        m->cells[cellIndex(m, (CellCord){tempStair.startFloor, tempStair.startBlockWidth, tempStair.startBlockLength})] = packCell(STAIR_CELL, tempStair.stairId);
 
-        maze[tempStair.endFloor][tempStair.endBlockWidth][tempStair.endBlockLength].cellType = STAIR_CELL;
-        maze[tempStair.endFloor][tempStair.endBlockWidth][tempStair.endBlockLength].cellTypeId = tempStair.stairId;
+        m->cells[cellIndex(m, (CellCord){tempStair.endFloor, tempStair.endBlockWidth, tempStair.endBlockLength})] = packCell(STAIR_CELL, tempStair.stairId);
     }
 }
 
-void addPolesToMaze()
+void addPolesToMaze(Maze *m)
 {
-    for (int i = 0; i < no_Poles; i++)
+    if (m->no_Poles > MAX_CELL_ID + 1) // ids must fit in a packed cell
+    {
+        printf("\nError: Too many poles, at most %d are supported.\n", MAX_CELL_ID + 1);
+        exit(1);
+    }
+    for (int i = 0; i < m->no_Poles; i++)
     {
-        struct Pole tempPole = poles[i];
+        struct Pole tempPole = m->poles[i];
         for (int f = tempPole.startFloor; f <= tempPole.endFloor; f++)
         {
-            maze[f][tempPole.widthCell][tempPole.lengthCell].cellType = POLE_CELL;
-            maze[f][tempPole.widthCell][tempPole.lengthCell].cellTypeId = tempPole.poleId;
+            m->cells[cellIndex(m, (CellCord){f, tempPole.widthCell, tempPole.lengthCell})] = packCell(POLE_CELL, tempPole.poleId);
         }
     }
 }
 
-void addWallstoMaze()
+void addWallstoMaze(Maze *m)
 {
-    for (int i = 0; i < no_Walls; i++)
+    for (int i = 0; i < m->no_Walls; i++)
     {
-        struct Wall tempWall = walls[i];
+        struct Wall tempWall = m->walls[i];
 
         if (tempWall.startBlockWidth == tempWall.endBlockWidth)
         {
             int step = (tempWall.startBlockLength < tempWall.endBlockLength) ? 1 : -1;
             for (int l = tempWall.startBlockLength; l != tempWall.endBlockLength + step; l += step)
             {
-                maze[tempWall.floor][tempWall.startBlockWidth][l].cellType = WALL_CELL;
+                m->cells[cellIndex(m, (CellCord){tempWall.floor, tempWall.startBlockWidth, l})] = packCell(WALL_CELL, -1);
             }
         }
         else
@@ -554,38 +1168,353 @@ void addWallstoMaze()
             int step = (tempWall.startBlockWidth < tempWall.endBlockWidth) ? 1 : -1;
             for (int w = tempWall.startBlockWidth; w != tempWall.endBlockWidth + step; w += step)
             {
-                maze[tempWall.floor][w][tempWall.startBlockLength].cellType = WALL_CELL;
+                m->cells[cellIndex(m, (CellCord){tempWall.floor, w, tempWall.startBlockLength})] = packCell(WALL_CELL, -1);
+            }
+        }
+    }
+}
+
+void addFlagToMaze(Maze *m)
+{
+    m->cells[cellIndex(m, m->Flag)] = packCell(FLAG_CELL, -1);
+}
+
+// ----------------------------------------PACK WALKABLE CELLS----------------------------------------
+void buildWalkableBits(Maze *m)
+{
+    memset(m->walkable, 0, rowOffset(m, m->floors, 0) * sizeof(uint64_t));
+    for (int f = 0; f < m->floors; f++)
+    {
+        for (int w = 0; w < m->width; w++)
+        {
+            for (int l = 0; l < m->length; l++)
+            {
+                if (!isBlockedCell(m, (CellCord){f, w, l}))
+                {
+                    setRowBit(m->walkable + rowOffset(m, f, w), l);
+                }
+            }
+        }
+    }
+}
+
+// ----------------------------------------LABEL WALKING REGIONS----------------------------------------
+// cells a player can walk between without taking a stair or a pole share a region
+void buildRegions(Maze *m)
+{
+    int *stack = (int *)malloc(m->noCells * sizeof(int));
+    if (!stack)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int c = 0; c < m->noCells; c++)
+    {
+        m->region[c] = -1;
+    }
+
+    int count = 0;
+    for (int c = 0; c < m->noCells; c++)
+    {
+        if (m->region[c] != -1 || isBlockedCell(m, cellFromIndex(m, c)))
+        {
+            continue;
+        }
+        int top = 0;
+        stack[top++] = c;
+        m->region[c] = count;
+        while (top > 0)
+        {
+            CellCord cell = cellFromIndex(m, stack[--top]);
+            for (Direction d = NORTH; d <= WEST; d++)
+            {
+                CellCord next = getNextCellCoord(cell, d);
+                if (isValidCordinates(m, next) && !isBlockedCell(m, next) && m->region[cellIndex(m, next)] == -1)
+                {
+                    m->region[cellIndex(m, next)] = count;
+                    stack[top++] = cellIndex(m, next);
+                }
+            }
+        }
+        count++;
+    }
+    m->no_Regions = count;
+    free(stack);
+
+    // regions joined by stairs and poles
+    m->stairLinks = (struct StairLink *)malloc((m->no_Stairs + 1) * sizeof(struct StairLink));
+    m->poleEdges = (struct RegionEdge *)malloc((m->no_Poles * m->floors + 1) * sizeof(struct RegionEdge));
+    if (!m->stairLinks || !m->poleEdges)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        struct Stair s = m->stairs[i];
+        Cell start = m->cells[cellIndex(m, (CellCord){s.startFloor, s.startBlockWidth, s.startBlockLength})];
+        Cell end = m->cells[cellIndex(m, (CellCord){s.endFloor, s.endBlockWidth, s.endBlockLength})];
+        struct StairLink link = {.startRegion = m->region[cellIndex(m, (CellCord){s.startFloor, s.startBlockWidth, s.startBlockLength})],
+                                 .endRegion = m->region[cellIndex(m, (CellCord){s.endFloor, s.endBlockWidth, s.endBlockLength})]};
+        int up = link.startRegion != link.endRegion && cellTypeOf(start) == STAIR_CELL && cellIdOf(start) == i ? RIDE_UP : 0;
+        int down = link.startRegion != link.endRegion && cellTypeOf(end) == STAIR_CELL && cellIdOf(end) == i ? RIDE_DOWN : 0;
+        link.rides[UP] = up;
+        link.rides[DOWN] = down;
+        link.rides[BI_DIR] = up | down;
+        m->stairLinks[i] = link;
+    }
+    m->no_PoleEdges = 0;
+    for (int i = 0; i < m->no_Poles; i++)
+    {
+        struct Pole p = m->poles[i];
+        int bottom = m->region[cellIndex(m, (CellCord){p.startFloor, p.widthCell, p.lengthCell})];
+        for (int f = p.startFloor + 1; f <= p.endFloor; f++)
+        {
+            Cell cell = m->cells[cellIndex(m, (CellCord){f, p.widthCell, p.lengthCell})];
+            int from = m->region[cellIndex(m, (CellCord){f, p.widthCell, p.lengthCell})];
+            if (cellTypeOf(cell) == POLE_CELL && cellIdOf(cell) == i && from != bottom)
+            {
+                m->poleEdges[m->no_PoleEdges++] = (struct RegionEdge){from, bottom};
             }
         }
     }
 }
 
-void addFlagToMaze()
+// ----------------------------------------PLAYER START CELLS---------------------------------------
+// the first three players start where A, B and C always did, every other player on a cell drawn from the edge of
+// the starting area, facing the way out of it. many players share a start cell in a crowded game
+void placePlayers(Maze *m, int count, unsigned int seed)
 {
-    maze[Flag.floor][Flag.width][Flag.length].cellType = FLAG_CELL;
+    const CellCord firstCells[DEFAULT_PLAYERS] = {{0, 6, 12}, {0, 9, 8}, {0, 9, 16}};
+    const Direction firstDirs[DEFAULT_PLAYERS] = {NORTH, WEST, EAST};
+
+    free(m->startCells);
+    free(m->startDirs);
+    m->no_Players = count;
+    m->startCells = (CellCord *)malloc(count * sizeof(CellCord));
+    m->startDirs = (Direction *)malloc(count * sizeof(Direction));
+    CellCord *exitCells = (CellCord *)malloc(4 * MIN_WIDTH * MIN_LENGTH * sizeof(CellCord));
+    Direction *exitDirs = (Direction *)malloc(4 * MIN_WIDTH * MIN_LENGTH * sizeof(Direction));
+    if (!m->startCells || !m->startDirs || !exitCells || !exitDirs)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    int exits = 0;
+    for (int w = 0; w < MIN_WIDTH; w++)
+    {
+        for (int l = 0; l < MIN_LENGTH; l++)
+        {
+            CellCord cell = {0, w, l};
+            for (Direction d = NORTH; d <= WEST && isStartingAreaCell(m, cell); d++)
+            {
+                CellCord next = getNextCellCoord(cell, d);
+                if (isValidCordinates(m, next) && !isBlockedCell(m, next) && !isStartingAreaCell(m, next))
+                {
+                    exitCells[exits] = cell;
+                    exitDirs[exits++] = d;
+                }
+            }
+        }
+    }
+
+    Rng rng;
+    rngInit(&rng, seed, RNG_PLAYER_STREAM);
+    for (int p = 0; p < count; p++)
+    {
+        if (p < DEFAULT_PLAYERS || exits == 0)
+        {
+            m->startCells[p] = firstCells[p % DEFAULT_PLAYERS];
+            m->startDirs[p] = firstDirs[p % DEFAULT_PLAYERS];
+        }
+        else
+        {
+            int e = (int)rngBelow(&rng, exits);
+            m->startCells[p] = exitCells[e];
+            m->startDirs[p] = exitDirs[e];
+        }
+    }
+    free(exitCells);
+    free(exitDirs);
 }
 
 // ----------------------------------------CALLING FUNCTIONS----------------------------------------
 
-void intializeMaze()
+// take the grid of a maze of the size and areas already set from one arena
+void allocateMaze(Maze *m)
+{
+    m->rowWords = (m->length + 63) / 64;
+    m->noCells = m->floors * m->width * m->length;
+
+    size_t cellBytes = m->noCells * sizeof(Cell);
+    size_t walkableBytes = rowOffset(m, m->floors, 0) * sizeof(uint64_t);
+    size_t regionBytes = m->noCells * sizeof(int);
+    arenaInit(&m->arena, arenaBlockSize(cellBytes) + arenaBlockSize(walkableBytes) + arenaBlockSize(regionBytes));
+    m->cells = (Cell *)arenaAlloc(&m->arena, cellBytes);
+    m->walkable = (uint64_t *)arenaAlloc(&m->arena, walkableBytes);
+    m->region = (int *)arenaAlloc(&m->arena, regionBytes);
+}
+
+// movement points, Bawana, the packed rows, regions and start cells of a maze whose objects are in place
+void finishMaze(Maze *m, Rng *rng, unsigned int seed)
+{
+    addMovementPointsToCells(m, rng);
+
+    bawanaSetUp(m, rng);
+
+    buildWalkableBits(m);
+    buildRegions(m);
+
+    placePlayers(m, DEFAULT_PLAYERS, seed);
+}
+
+// build a maze whose size and areas are set, movement points and Bawana are shuffled from the seed's maze stream
+void buildMaze(Maze *m, unsigned int seed)
+{
+    Rng rng;
+    rngInit(&rng, seed, RNG_MAZE_STREAM);
+
+    allocateMaze(m);
+    setUpFloors(m);
+
+    loadFlag(m);
+    addFlagToMaze(m);
+
+    initOccupancy(m); // every object is checked against the ones loaded before it
+
+    EntryList stairs, poles; // read ahead, the walls keep their ends joined
+    readStairsFile(&stairs, "stairs.txt");
+    readPolesFile(&poles, "poles.txt");
+
+    initBlockedSets(m);
+    linkObjectEnds(m, &stairs, &poles);
+    loadWalls(m);
+    addWallstoMaze(m);
+    freeBlockedSets(m);
+
+    layStairsFile(m, &stairs, "stairs.txt");
+    addStairsToMaze(m);
+
+    layPolesFile(m, &poles, "poles.txt");
+    addPolesToMaze(m);
+
+    freeOccupancy(m);
+
+    finishMaze(m, &rng, seed);
+}
+
+// where a maze's flag and objects come from when they are not the text files
+typedef struct
+{
+    CellCord flag;
+    const EntryList *walls;
+    const EntryList *stairs;
+    const EntryList *poles;
+} MazeLayout;
+
+// build a maze whose size and areas are set from a layout, the steps of buildMaze without leaving the program on a
+// bad layout. objects that break a rule are logged and left out, false if the flag cell is not vacant or a kind of
+// object has no valid entry. the maze can be freed either way
+bool layMaze(Maze *m, unsigned int seed, const MazeLayout *layout)
 {
-    setUpFloors(maze);
+    Rng rng;
+    rngInit(&rng, seed, RNG_MAZE_STREAM);
+
+    allocateMaze(m);
+    setUpFloors(m);
+
+    if (!isVacantCell(m, layout->flag))
+    {
+        return false;
+    }
+    m->Flag = layout->flag;
+    addFlagToMaze(m);
 
-    loadFlag();
-    addFlagToMaze();
+    initOccupancy(m);
 
-    loadWalls();
-    addWallstoMaze();
+    initBlockedSets(m);
+    linkObjectEnds(m, layout->stairs, layout->poles);
+    bool laid = layWalls(m, layout->walls) > 0;
+    addWallstoMaze(m);
+    freeBlockedSets(m);
 
-    loadStairs();
-    addStairsToMaze();
+    laid = laid && layStairs(m, layout->stairs) > 0;
+    if (laid)
+    {
+        addStairsToMaze(m);
+    }
+    laid = laid && layPoles(m, layout->poles) > 0;
+    if (laid)
+    {
+        addPolesToMaze(m);
+    }
+
+    freeOccupancy(m);
+    if (laid)
+    {
+        finishMaze(m, &rng, seed);
+    }
+    return laid;
+}
 
-    loadPoles();
-    addPolesToMaze();
+// give an empty maze the size and floor areas of another, to lay out on its own
+void copyMazeSize(Maze *into, const Maze *from)
+{
+    into->floors = from->floors;
+    into->width = from->width;
+    into->length = from->length;
+    into->no_Areas = from->no_Areas;
+    into->areas = (struct FloorArea *)malloc(from->no_Areas * sizeof(struct FloorArea));
+    if (!into->areas)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    memcpy(into->areas, from->areas, from->no_Areas * sizeof(struct FloorArea));
+}
 
-    addMovementPointsToCells();
+// build the maze described by maze.txt and the object files
+void intializeMaze(Maze *m, unsigned int seed)
+{
+    loadMazeSize(m);
+    buildMaze(m, seed);
+}
 
-    bawanaSetUp();
+// release the objects loaded into the maze
+void freeMaze(Maze *m)
+{
+    if (m->snapshot.size)
+    {
+        unmapFile(&m->snapshot);
+    }
+    else
+    {
+        free(m->stairs);
+        free(m->poles);
+        free(m->walls);
+        free(m->bawanaCells);
+        free(m->stepTable);
+        free(m->areas);
+        arenaFree(&m->arena);
+        free(m->stairLinks);
+        free(m->poleEdges);
+    }
+    free(m->startCells);
+    free(m->startDirs);
+    m->stairs = NULL;
+    m->poles = NULL;
+    m->walls = NULL;
+    m->bawanaCells = NULL;
+    m->stepTable = NULL;
+    m->areas = NULL;
+    m->cells = NULL;
+    m->walkable = NULL;
+    m->region = NULL;
+    m->stairLinks = NULL;
+    m->poleEdges = NULL;
+    m->startCells = NULL;
+    m->startDirs = NULL;
 }
 
 #endif
\ No newline at end of file
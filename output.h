@@ -0,0 +1,263 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+#include "events.h"
+
+// ----------------------------------------ASYNC OUTPUT---------------------------------------
+// game threads hand their events to a writer thread through one single producer ring each, the writer formats
+// them into a large buffer that reaches the file in big writes. a game thread only copies the event into its ring,
+// it waits only if the writer is a whole ring behind
+
+#define OUTPUT_RING_RECORDS (1 << 14) // per game thread, a power of two
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+typedef enum
+{
+    OUTPUT_SILENT,  // nothing
+    OUTPUT_SUMMARY, // one line per game
+    OUTPUT_FULL     // every event of every game, the narration
+} Verbosity;
+
+// the level named on the command line, -1 if there is none by that name
+int parseVerbosity(const char *name)
+{
+    const char *names[] = {"silent", "summary", "full"};
+    for (int i = 0; i < 3; i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+typedef struct
+{
+    long game; // -1 for a game that is not part of a batch
+    GameEvent event;
+} OutputRecord;
+
+typedef struct
+{
+    OutputRecord *records;
+    long game;      // game the events written now belong to
+    long stalls;    // times the ring was full and the game thread waited for the writer
+    EventSink sink; // events of a game into this ring
+    char pad[64];   // keep the two ends on their own cache lines
+    _Atomic size_t head; // next record the writer takes
+    char pad2[64];
+    _Atomic size_t tail; // next record the game thread fills
+} OutputRing;
+
+typedef struct
+{
+    Verbosity level;
+    FILE *out;
+    bool piped; // out is a pipe into gzip
+    char *buffer;
+    OutputRing *rings;
+    int no_Rings;
+    long records;  // records written, only touched by the writer
+    long lastGame; // game of the last record written
+    pthread_t writer;
+    _Atomic bool done;
+} Output;
+
+void yieldThread()
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+void sleepBriefly()
+{
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec pause = {0, 200000};
+    nanosleep(&pause, NULL);
+#endif
+}
+
+void pushRecord(OutputRing *r, long game, const GameEvent *event)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    while (tail - atomic_load_explicit(&r->head, memory_order_acquire) >= OUTPUT_RING_RECORDS)
+    {
+        r->stalls++;
+        yieldThread();
+    }
+    r->records[tail & (OUTPUT_RING_RECORDS - 1)] = (OutputRecord){game, *event};
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+void writeRingEvent(void *context, const GameEvent *event)
+{
+    OutputRing *r = (OutputRing *)context;
+    pushRecord(r, r->game, event);
+}
+
+void writeRecord(Output *o, const OutputRecord *r)
+{
+    if (r->game >= 0 && r->event.kind != EVENT_GAME_END && r->game != o->lastGame)
+    {
+        fprintf(o->out, "\n======================== Game %ld ========================\n", r->game);
+    }
+    if (r->game >= 0 && r->event.kind == EVENT_GAME_END)
+    {
+        fprintf(o->out, "Game %ld: ", r->game);
+    }
+    o->lastGame = r->game;
+    writeEventText(o->out, &r->event);
+    o->records++;
+}
+
+void *outputWriterRun(void *arg)
+{
+    Output *o = (Output *)arg;
+    while (1)
+    {
+        // once done is seen every ring is complete, so one more pass empties them for good
+        bool done = atomic_load_explicit(&o->done, memory_order_acquire);
+        bool wrote = false;
+        for (int i = 0; i < o->no_Rings; i++)
+        {
+            OutputRing *r = &o->rings[i];
+            size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+            size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+            wrote |= head != tail;
+            for (; head != tail; head++)
+            {
+                writeRecord(o, &r->records[head & (OUTPUT_RING_RECORDS - 1)]);
+                if ((head & 255) == 255)
+                { // give room back to the game thread while still draining
+                    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+                }
+            }
+            atomic_store_explicit(&r->head, head, memory_order_release);
+        }
+        if (done)
+        {
+            break;
+        }
+        if (!wrote)
+        {
+            sleepBriefly();
+        }
+    }
+    return NULL;
+}
+
+// write to path, or to stdout if it is NULL, through a pipe into gzip if path ends in ".gz"
+void openOutput(Output *o, const char *path, Verbosity level, int rings)
+{
+    *o = (Output){.level = level};
+    o->lastGame = -1;
+    size_t length = path ? strlen(path) : 0;
+    if (!path)
+    {
+        o->out = stdout;
+    }
+    else if (length > 3 && strcmp(path + length - 3, ".gz") == 0)
+    {
+        char command[1024];
+        snprintf(command, sizeof(command), "gzip -c > \"%s\"", path);
+#ifdef _WIN32
+        o->out = _popen(command, "wb");
+#else
+        o->out = popen(command, "w");
+#endif
+        o->piped = true;
+    }
+    else
+    {
+        o->out = fopen(path, "w");
+    }
+    o->buffer = (char *)malloc(OUTPUT_BUFFER_SIZE);
+    o->rings = (OutputRing *)calloc(rings, sizeof(OutputRing));
+    if (!o->out || !o->buffer || !o->rings)
+    {
+        printf("\nError: Could not open %s for output.\n", path ? path : "stdout");
+        exit(1);
+    }
+    fflush(o->out);
+    setvbuf(o->out, o->buffer, _IOFBF, OUTPUT_BUFFER_SIZE);
+
+    o->no_Rings = rings;
+    for (int i = 0; i < rings; i++)
+    {
+        o->rings[i].records = (OutputRecord *)malloc(OUTPUT_RING_RECORDS * sizeof(OutputRecord));
+        if (!o->rings[i].records)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+        o->rings[i].game = -1;
+        o->rings[i].sink = (EventSink){writeRingEvent, &o->rings[i]};
+    }
+    if (pthread_create(&o->writer, NULL, outputWriterRun, o) != 0)
+    {
+        printf("\nError: Could not start output thread.\n");
+        exit(1);
+    }
+}
+
+// the sink a game on thread i tells its events to, NULL below full verbosity
+const EventSink *outputSink(Output *o, int i) { return o && o->level == OUTPUT_FULL ? &o->rings[i].sink : NULL; }
+
+// a game of the batch ended, told from summary verbosity up
+void outputGameEnd(Output *o, int i, long game, int winner, int rounds)
+{
+    if (o && o->level >= OUTPUT_SUMMARY)
+    {
+        GameEvent end = {.kind = EVENT_GAME_END, .player = winner, .value = rounds};
+        pushRecord(&o->rings[i], game, &end);
+    }
+}
+
+// let the writer empty every ring and finish the file, returns the times game threads waited for room
+long closeOutput(Output *o)
+{
+    long stalls = 0;
+    atomic_store_explicit(&o->done, true, memory_order_release);
+    pthread_join(o->writer, NULL);
+    for (int i = 0; i < o->no_Rings; i++)
+    {
+        stalls += o->rings[i].stalls;
+        free(o->rings[i].records);
+    }
+    fflush(o->out);
+    if (o->piped)
+    {
+#ifdef _WIN32
+        _pclose(o->out);
+#else
+        pclose(o->out);
+#endif
+    }
+    else if (o->out != stdout)
+    {
+        fclose(o->out);
+    }
+    else
+    {
+        setvbuf(stdout, NULL, _IOLBF, BUFSIZ); // the buffer is freed below
+    }
+    free(o->buffer);
+    free(o->rings);
+    return stalls;
+}
+
+#endif
@@ -0,0 +1,281 @@
+#ifndef PARSE_H
+#define PARSE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ----------------------------------------MAPPED FILES---------------------------------------
+// a whole file mapped read only into memory, so it can be parsed in one pass without copying it
+
+typedef struct
+{
+    const char *data;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+} MappedFile;
+
+bool mapFile(MappedFile *f, const char *path)
+{
+    f->data = "";
+    f->size = 0;
+#ifdef _WIN32
+    f->mapping = NULL;
+    f->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f->file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    GetFileSizeEx(f->file, &size);
+    f->size = (size_t)size.QuadPart;
+    if (f->size == 0) // an empty file can not be mapped
+    {
+        return true;
+    }
+    f->mapping = CreateFileMappingA(f->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    f->data = f->mapping ? (const char *)MapViewOfFile(f->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    struct stat info;
+    f->fd = open(path, O_RDONLY);
+    if (f->fd < 0)
+    {
+        return false;
+    }
+    fstat(f->fd, &info);
+    f->size = (size_t)info.st_size;
+    if (f->size == 0) // an empty file can not be mapped
+    {
+        return true;
+    }
+    void *data = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, f->fd, 0);
+    f->data = data == MAP_FAILED ? NULL : (const char *)data;
+#endif
+    if (!f->data)
+    {
+        printf("\nError: Could not map %s into memory.\n", path);
+        exit(1);
+    }
+    return true;
+}
+
+void unmapFile(MappedFile *f)
+{
+#ifdef _WIN32
+    if (f->size)
+    {
+        UnmapViewOfFile(f->data);
+        CloseHandle(f->mapping);
+    }
+    CloseHandle(f->file);
+#else
+    if (f->size)
+    {
+        munmap((void *)f->data, f->size);
+    }
+    close(f->fd);
+#endif
+    f->data = "";
+    f->size = 0;
+}
+
+// ----------------------------------------ENTRY TOKENIZER---------------------------------------
+// reads entries of the form "[a, b, c, ...]", one per line, the format of the maze object files
+
+typedef struct
+{
+    const char *pos;
+    const char *end;
+} Tokenizer;
+
+void initTokenizer(Tokenizer *t, const MappedFile *f)
+{
+    t->pos = f->data;
+    t->end = f->data + f->size;
+}
+
+// upper bound on the entries in a file, every entry opens with '['
+int countEntries(const MappedFile *f)
+{
+    int count = 0;
+    const char *end = f->data + f->size;
+    for (const char *p = f->data; (p = memchr(p, '[', end - p)) != NULL; p++)
+    {
+        count++;
+    }
+    return count;
+}
+
+void skipSpaces(Tokenizer *t)
+{
+    while (t->pos < t->end && (*t->pos == ' ' || *t->pos == '\t' || *t->pos == '\r' || *t->pos == '\n'))
+    {
+        t->pos++;
+    }
+}
+
+// skip blanks inside an entry, a line break ends the entry
+void skipBlanks(Tokenizer *t)
+{
+    while (t->pos < t->end && (*t->pos == ' ' || *t->pos == '\t' || *t->pos == '\r'))
+    {
+        t->pos++;
+    }
+}
+
+bool readInt(Tokenizer *t, int *value)
+{
+    bool negative = false;
+    if (t->pos < t->end && (*t->pos == '-' || *t->pos == '+'))
+    {
+        negative = *t->pos++ == '-';
+    }
+    if (t->pos >= t->end || *t->pos < '0' || *t->pos > '9')
+    {
+        return false;
+    }
+    long long v = 0;
+    while (t->pos < t->end && *t->pos >= '0' && *t->pos <= '9')
+    {
+        if (v < 100000000000LL) // keep the value bounded, anything this big is rejected by validation anyway
+        {
+            v = v * 10 + (*t->pos - '0');
+        }
+        t->pos++;
+    }
+    v = negative ? -v : v;
+    *value = v > 0x7FFFFFFF ? 0x7FFFFFFF : v < -0x7FFFFFFF ? -0x7FFFFFFF : (int)v;
+    return true;
+}
+
+bool expectChar(Tokenizer *t, char c)
+{
+    skipBlanks(t);
+    if (t->pos < t->end && *t->pos == c)
+    {
+        t->pos++;
+        return true;
+    }
+    return false;
+}
+
+// read the next entry of count integers. returns count, EOF at the end of the input, or the integers read
+// before the entry turned out malformed, in which case the rest of its line is skipped
+int readEntry(Tokenizer *t, int *values, int count)
+{
+    skipSpaces(t);
+    if (t->pos >= t->end)
+    {
+        return EOF;
+    }
+
+    int read = 0;
+    if (expectChar(t, '['))
+    {
+        while (read < count)
+        {
+            skipBlanks(t);
+            if (!readInt(t, &values[read]))
+            {
+                break;
+            }
+            read++;
+            if (!expectChar(t, read < count ? ',' : ']'))
+            {
+                read = read < count ? read : count - 1; // a missing ']' makes the entry malformed too
+                break;
+            }
+        }
+    }
+    if (read == count)
+    {
+        return count;
+    }
+
+    const char *newline = memchr(t->pos, '\n', t->end - t->pos);
+    t->pos = newline ? newline + 1 : t->end;
+    return read;
+}
+
+// ----------------------------------------ENTRY LISTS---------------------------------------
+// every well formed entry of an object file with the line it is on, read once so it can be laid into many mazes
+
+typedef struct
+{
+    int width;   // integers per entry
+    int count;
+    int *values; // [entry * width + i]
+    int *lines;  // [entry] line of the file it came from
+} EntryList;
+
+// read the entries of width integers from the file, malformed lines are logged and left out. a file that opens
+// with an entry of its own, like the size line of maze.txt, passes its headerWidth and gets it in header. returns
+// the integers of the header read (headerWidth if it is well formed), or EOF if the file can not be opened
+int readEntryFile(EntryList *e, const char *path, int width, int *header, int headerWidth)
+{
+    MappedFile file;
+    if (!mapFile(&file, path))
+    {
+        return EOF;
+    }
+    int capacity = countEntries(&file) + 1;
+    e->width = width;
+    e->count = 0;
+    e->values = (int *)malloc(capacity * width * sizeof(int));
+    e->lines = (int *)malloc(capacity * sizeof(int));
+    if (!e->values || !e->lines)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    Tokenizer tokens;
+    initTokenizer(&tokens, &file);
+    int values, line = 0, headerRead = 0;
+    if (headerWidth)
+    {
+        headerRead = readEntry(&tokens, header, headerWidth);
+        headerRead = headerRead == EOF ? 0 : headerRead; // an empty file has a malformed header
+        line++;
+    }
+    while ((values = readEntry(&tokens, e->values + e->count * width, width)) != EOF)
+    {
+        line++;
+        if (values != width)
+        {
+            fprintf(stderr, "Line %d of %s: Malformed input (expected %d integers)\n", line, path, width);
+            continue;
+        }
+        e->lines[e->count++] = line;
+    }
+    unmapFile(&file);
+    return headerRead;
+}
+
+// read the entries of width integers from the file. false if the file can not be opened
+bool readEntryList(EntryList *e, const char *path, int width) { return readEntryFile(e, path, width, NULL, 0) != EOF; }
+
+void freeEntryList(EntryList *e)
+{
+    free(e->values);
+    free(e->lines);
+    e->values = NULL;
+    e->lines = NULL;
+    e->count = 0;
+}
+
+#endif
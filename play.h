@@ -5,53 +5,74 @@
 #include "helpers.h"
 
 // ----------------------------------------INITIALIZE PLAYERS---------------------------------------
-void initPlayers()
+// the maze's players, all on their start cells
+void allocatePlayers(Players *ps, const Maze *m)
 {
+    int count = m->no_Players;
+    ps->count = count;
+    ps->currentCell = (CellCord *)malloc(count * sizeof(CellCord));
+    ps->movementPoints = (int *)malloc(count * sizeof(int));
+    ps->dir = (Direction *)malloc(count * sizeof(Direction));
+    ps->status = (PlayerStatus *)malloc(count * sizeof(PlayerStatus));
+    ps->throwsCount = (int *)malloc(count * sizeof(int));
+    ps->throwsLeftInStatus = (int *)malloc(count * sizeof(int));
+    ps->occupant = (int *)malloc(m->noCells * sizeof(int));
+    ps->next = (int *)malloc(count * sizeof(int));
+    ps->prev = (int *)malloc(count * sizeof(int));
+    ps->captured = (int *)malloc(count * sizeof(int));
+    if (!ps->currentCell || !ps->movementPoints || !ps->dir || !ps->status || !ps->throwsCount || !ps->throwsLeftInStatus ||
+        !ps->occupant || !ps->next || !ps->prev || !ps->captured)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    memset(ps->occupant, 0xFF, m->noCells * sizeof(int));
+    memcpy(ps->currentCell, m->startCells, count * sizeof(CellCord));
+}
+
+void freePlayers(Players *ps)
+{
+    free(ps->currentCell);
+    free(ps->movementPoints);
+    free(ps->dir);
+    free(ps->status);
+    free(ps->throwsCount);
+    free(ps->throwsLeftInStatus);
+    free(ps->occupant);
+    free(ps->next);
+    free(ps->prev);
+    free(ps->captured);
+    *ps = (Players){0};
+}
 
-    players[0] = (Player){
-        'A',
-        (CellCord){0, 6, 12},
-        (CellCord){0, 6, 12},
-        NORTH,
-        NORTH,
-        100,
-        0,
-        STARTING_AREA,
-        0};
-
-    players[1] = (Player){
-        'B',
-        (CellCord){0, 9, 8},
-        (CellCord){0, 9, 8},
-        WEST,
-        WEST,
-        100,
-        0,
-        STARTING_AREA,
-        0};
-
-    players[2] = (Player){
-        'C',
-        (CellCord){0, 9, 16},
-        (CellCord){0, 9, 16},
-        EAST,
-        EAST,
-        100,
-        0,
-        STARTING_AREA,
-        0};
+// every player back on their start cell with 100 movement points
+void initPlayers(Game *g)
+{
+    Players *ps = &g->players;
+    unlinkAllPlayers(g);
+    for (int p = 0; p < ps->count; p++)
+    {
+        ps->currentCell[p] = g->maze->startCells[p];
+        ps->movementPoints[p] = 100;
+        ps->dir[p] = g->maze->startDirs[p];
+        ps->status[p] = STARTING_AREA;
+        ps->throwsCount[p] = 0;
+        ps->throwsLeftInStatus[p] = 0;
+    }
+    linkAllPlayers(g);
 }
 
 // ----------------------------------------MOVEMENT HELP---------------------------------------
 
-bool takeStair(CellCord *c, int index)
+bool takeStair(const Game *g, CellCord *c, int index)
 {
-    CellCord stairStart = {stairs[index].startFloor, stairs[index].startBlockWidth, stairs[index].startBlockLength};
-    CellCord stairEnd = {stairs[index].endFloor, stairs[index].endBlockWidth, stairs[index].endBlockLength};
+    const struct Stair *stair = &g->maze->stairs[index];
+    CellCord stairStart = {stair->startFloor, stair->startBlockWidth, stair->startBlockLength};
+    CellCord stairEnd = {stair->endFloor, stair->endBlockWidth, stair->endBlockLength};
     bool atStairStart = isSameCord(*c, stairStart);
     bool atStairEnd = isSameCord(*c, stairEnd);
 
-    StairDirection dir = stairs[index].dir;
+    StairDirection dir = stairDirection(g, index);
 
     if ((dir == UP && atStairEnd) || (dir == DOWN && atStairStart))
     {
@@ -68,10 +89,10 @@ bool takeStair(CellCord *c, int index)
     return true;
 }
 
-bool takePole(CellCord *c, int index)
+bool takePole(const Maze *m, CellCord *c, int index)
 {
-    CellCord poleStart = {poles[index].startFloor, poles[index].widthCell, poles[index].lengthCell};
-    CellCord poleEnd = {poles[index].endFloor, poles[index].widthCell, poles[index].lengthCell};
+    CellCord poleStart = {m->poles[index].startFloor, m->poles[index].widthCell, m->poles[index].lengthCell};
+    CellCord poleEnd = {m->poles[index].endFloor, m->poles[index].widthCell, m->poles[index].lengthCell};
 
     if (c->floor > poleStart.floor && c->floor <= poleEnd.floor)
     {
@@ -82,293 +103,393 @@ bool takePole(CellCord *c, int index)
 }
 
 // calc movement ponts for a single step
-void calcMovementPoints(CellCord cell, Move *move)
+void calcMovementPoints(const Maze *m, CellCord cell, Move *move)
 {
-    switch (maze[cell.floor][cell.width][cell.length].effectType)
+    Cell c = m->cells[cellIndex(m, cell)];
+    switch (cellEffectOf(c))
     {
     case MP_CONSUME:
-        move->movementPoints -= maze[cell.floor][cell.width][cell.length].effectValue;
+        move->movementPoints -= cellEffectValueOf(c);
         break;
 
     case MP_ADD:
-        move->movementPoints += maze[cell.floor][cell.width][cell.length].effectValue;
+        move->movementPoints += cellEffectValueOf(c);
         break;
 
     case MP_MULTIPLY:
-        move->mpMultiplyer *= maze[cell.floor][cell.width][cell.length].effectValue;
+        move->mpMultiplyer *= cellEffectValueOf(c);
     }
 }
 
 // apply effect to player according to the bawana cell they land on
-void applyBawanaEffect(Player *p, struct BawanaCell *bawanaCell)
+void applyBawanaEffect(Game *g, int p, struct BawanaCell *bawanaCell)
 {
+    Players *ps = &g->players;
+    EMIT(g, {.kind = EVENT_BAWANA, .player = p, .value = bawanaCell->type, .mp = bawanaCell->movementPoints});
+    g->bawanaVisits++;
     switch (bawanaCell->type)
     {
     case POISONED_CELL:
-        p->currentCell = bawanaCell->cellCoord;
-        p->movementPoints = bawanaCell->movementPoints;
-        p->status = POISONED;
-        p->throwsLeftInStatus = 3;
-        printf("%c eats from Bawana and have a bad case of food poisoning. Will need three rounds to recover.\n", p->name);
+        setPlayerCell(g, p, bawanaCell->cellCoord);
+        ps->movementPoints[p] = bawanaCell->movementPoints;
+        ps->status[p] = POISONED;
+        ps->throwsLeftInStatus[p] = 3;
         return;
 
     case DISORIENTED_CELL:
-        p->status = DISORIENTED;
-        p->throwsLeftInStatus = 4;
-        printf("%c eats from Bawana and is disoriented and is placed at the entrance of Bawana with 50 movement points.\n", p->name);
+        ps->status[p] = DISORIENTED;
+        ps->throwsLeftInStatus[p] = 4;
         break;
 
     case TRIGGERED_CELL:
-        p->status = TRIGGERED;
-        p->throwsLeftInStatus = 4;
-        printf("%c eats from Bawana and is triggered due to bad quality of food. %c is placed at the entrance of Bawana with 50 movement points.\n", p->name, p->name);
+        ps->status[p] = TRIGGERED;
+        ps->throwsLeftInStatus[p] = 4;
         break;
 
     case HAPPY_CELL:
-        p->status = IN_MAZE;
-        p->throwsLeftInStatus = 0;
-        printf("%c eats from Bawana and is happy. %c is placed at the entrance of Bawana with 200 movement points.\n", p->name, p->name);
-        break;
-
     case RANDOM_CELL:
-        p->status = IN_MAZE;
-        p->throwsLeftInStatus = 0;
-        printf("%c eats from Bawana and earns %d movement points and is placed at the entrance of Bawana.\n", p->name, bawanaCell->movementPoints);
+        ps->status[p] = IN_MAZE;
+        ps->throwsLeftInStatus[p] = 0;
         break;
     }
-    p->currentCell = BawanaEntry;
-    p->movementPoints = bawanaCell->movementPoints;
-    hasCapturedPlayer(p->name, BawanaEntry);
+    setPlayerCell(g, p, BawanaEntry);
+    ps->movementPoints[p] = bawanaCell->movementPoints;
+    hasCapturedPlayer(g, p, BawanaEntry);
 }
 
 // ----------------------------------------PLAYER MOVEMENT IMPLIMETATION---------------------------------------
 
 // check if player can move to next cell or blocked
-bool isNextStepPossible(CellCord current, Direction dir)
+bool isNextStepPossible(const Maze *m, CellCord current, Direction dir)
 {
     CellCord nextCoord = getNextCellCoord(current, dir);
-    return isValidCordinates(nextCoord) && !isBlockedCell(nextCoord);
+    return isValidCordinates(m, nextCoord) && !isBlockedCell(m, nextCoord);
 }
 
-// move player to next cell
-void movePlayer(Move *move, int *offset)
+// move player to next cell, a stair or pole taken is added to rides when the game has a sink
+void movePlayer(Game *g, Move *move, GameEvent *rides, int *count)
 {
-    int bytes_written; // update msgBuffer and offset
-
+    PROBE(PROBE_MOVE_PLAYER);
     CellCord nextCellCord = getNextCellCoord(move->currentCell, move->dir);
-    struct Cell nextCell = getNextCell(nextCellCord);
+    CellCord landedCellCord = nextCellCord;
+    Cell nextCell = getNextCell(g->maze, nextCellCord);
 
-    if (nextCell.cellType == STAIR_CELL) // check if player have to take a stair
+    if (cellTypeOf(nextCell) == STAIR_CELL) // check if player have to take a stair
     {
-        if (takeStair(&nextCellCord, nextCell.cellTypeId))
+        if (takeStair(g, &nextCellCord, cellIdOf(nextCell)) && g->sink)
         {
-            bytes_written = snprintf(move->msgBuffer + *offset, sizeof(move->msgBuffer) - *offset, "%c lands on %s which is a stair cell. %c takes the stairs and now placed at %s.\n",
-                                     move->player, cordToString(move->currentCell), move->player, cordToString(nextCellCord)); // add msg to msgBuffer
-
-            *offset += bytes_written;
+            rides[(*count)++] = (GameEvent){.kind = EVENT_STAIR, .player = move->player, .from = landedCellCord, .to = nextCellCord};
         }
     }
-    else if (nextCell.cellType == POLE_CELL) // check if player have to take a pole
+    else if (cellTypeOf(nextCell) == POLE_CELL) // check if player have to take a pole
     {
-        if (takePole(&nextCellCord, nextCell.cellTypeId))
+        if (takePole(g->maze, &nextCellCord, cellIdOf(nextCell)) && g->sink)
         {
-            bytes_written = snprintf(move->msgBuffer + *offset, sizeof(move->msgBuffer) - *offset, "%c lands on %s which is a pole cell. %c slides down and now placed at %s.\n",
-                                     move->player, cordToString(move->currentCell), move->player, cordToString(nextCellCord)); // add msg to msgBuffer
-
-            *offset += bytes_written;
+            rides[(*count)++] = (GameEvent){.kind = EVENT_POLE, .player = move->player, .from = landedCellCord, .to = nextCellCord};
         }
     }
-    else if (nextCell.cellType == FLAG_CELL) // check if player has reached the flag
+    else if (cellTypeOf(nextCell) == FLAG_CELL) // check if player has reached the flag
     {
-        printf("\n\n------------------------------------- Game Over -------------------------------------\n\n");
-        printf("%c has capture the flag at %s. The winner is %c.\n\n", move->player, cordToString(nextCellCord), move->player);
-        exit(0); // successfully complete the game.
+        EMIT(g, {.kind = EVENT_WIN, .player = move->player, .to = nextCellCord});
+        g->winner = move->player; // successfully complete the game.
     }
     move->currentCell = nextCellCord; // move player to next cell
-    calcMovementPoints(nextCellCord, move);
+    calcMovementPoints(g->maze, nextCellCord, move);
 }
 
-// check and do the players move
-bool isPlayerMoved(Move *move)
+// walk the move one step at a time. the stairs and poles taken are told once the whole move is done
+bool walkPlayerMove(Game *g, Move *move)
 {
-    int bufferOffset = 0; // keep track of msgBuffer in move
+    GameEvent rides[MAX_MOVE_STEPS];
+    int count = 0;
     for (int i = 0; i < move->steps; i++)
     {
-        if (isNextStepPossible(move->currentCell, move->dir))
+        if (isNextStepPossible(g->maze, move->currentCell, move->dir))
         {
-            movePlayer(move, &bufferOffset);
+            movePlayer(g, move, rides, &count);
+            if (g->winner != NO_WINNER)
+            {
+                return true; // flag captured, rest of the steps are not needed
+            }
         }
         else
         {
             return false;
         }
     }
+    for (int i = 0; i < count; i++)
+    {
+        g->sink->write(g->sink->context, &rides[i]);
+    }
     return true;
 }
 
+// ----------------------------------------PRECOMPUTED MOVES---------------------------------------
+// the table holds the result of 1..MAX_MOVE_STEPS steps from every cell in every direction. poles never change so
+// they are folded in. stairs change direction during a game, so an entry stops on the stair cell and the game
+// resolves it with its own stair directions. the table is read only and shared by every game on the maze.
+
+#define STEP_TABLE_MAX_CELLS 1000000 // about 576 bytes a cell, bigger mazes walk every move step by step
+
+int stepSlot(int cell, Direction dir, int steps) { return (cell * 4 + dir) * MAX_MOVE_STEPS + steps - 1; }
+
+// result of a single step from a cell
+struct StepEntry singleStep(const Maze *m, CellCord from, Direction dir)
+{
+    struct StepEntry entry = {cellIndex(m, from), 1, 0, 0, STEP_BLOCKED};
+    if (!isNextStepPossible(m, from, dir))
+    {
+        return entry;
+    }
+
+    CellCord next = getNextCellCoord(from, dir);
+    Cell cell = getNextCell(m, next);
+    entry.steps = 1;
+    if (cellTypeOf(cell) == STAIR_CELL)
+    {
+        entry.dest = cellIndex(m, next); // movement points are taken after the stair is resolved
+        entry.stop = STEP_STAIR;
+        return entry;
+    }
+    if (cellTypeOf(cell) == POLE_CELL)
+    {
+        takePole(m, &next, cellIdOf(cell));
+    }
+
+    Move points = {.mpMultiplyer = 1};
+    calcMovementPoints(m, next, &points);
+    entry.dest = cellIndex(m, next);
+    entry.mpAdd = (short)points.movementPoints;
+    entry.mpMultiply = points.mpMultiplyer;
+    entry.stop = cellTypeOf(cell) == FLAG_CELL ? STEP_FLAG : STEP_DONE;
+    return entry;
+}
+
+// build the table, k steps are one step followed by the (k - 1) step entry of the cell it lands on
+void buildStepTable(Maze *m)
+{
+    if (m->noCells > STEP_TABLE_MAX_CELLS)
+    {
+        m->stepTable = NULL;
+        return;
+    }
+    m->stepTable = (struct StepEntry *)malloc(m->noCells * 4 * MAX_MOVE_STEPS * sizeof(struct StepEntry));
+    if (!m->stepTable)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    for (int c = 0; c < m->noCells; c++)
+    {
+        for (Direction d = NORTH; d <= WEST; d++)
+        {
+            m->stepTable[stepSlot(c, d, 1)] = singleStep(m, cellFromIndex(m, c), d);
+        }
+    }
+
+    for (int k = 2; k <= MAX_MOVE_STEPS; k++)
+    {
+        for (int c = 0; c < m->noCells; c++)
+        {
+            for (Direction d = NORTH; d <= WEST; d++)
+            {
+                struct StepEntry entry = m->stepTable[stepSlot(c, d, 1)];
+                if (entry.stop == STEP_DONE)
+                {
+                    struct StepEntry rest = m->stepTable[stepSlot(entry.dest, d, k - 1)];
+                    entry.dest = rest.dest;
+                    entry.steps += rest.steps;
+                    entry.stop = rest.stop;
+                    entry.mpAdd += rest.mpAdd;
+                    entry.mpMultiply *= rest.mpMultiply;
+                }
+                m->stepTable[stepSlot(c, d, k)] = entry;
+            }
+        }
+    }
+}
+
+// same result as walkPlayerMove with one table lookup per stair on the way
+bool jumpPlayerMove(Game *g, Move *move)
+{
+    const Maze *m = g->maze;
+    int cell = cellIndex(m, move->currentCell);
+    int stepsLeft = move->steps;
+
+    while (stepsLeft > 0)
+    {
+        struct StepEntry entry = m->stepTable[stepSlot(cell, move->dir, stepsLeft)];
+        move->movementPoints += entry.mpAdd;
+        move->mpMultiplyer *= entry.mpMultiply;
+        stepsLeft -= entry.steps;
+        cell = entry.dest;
+
+        if (entry.stop == STEP_BLOCKED)
+        {
+            return false;
+        }
+        else if (entry.stop == STEP_FLAG)
+        {
+            g->winner = move->player;
+            break;
+        }
+        else if (entry.stop == STEP_STAIR)
+        {
+            CellCord stairCell = cellFromIndex(m, cell);
+            takeStair(g, &stairCell, cellIdOf(m->cells[cellIndex(m, stairCell)]));
+            calcMovementPoints(m, stairCell, move);
+            cell = cellIndex(m, stairCell);
+        }
+    }
+    move->currentCell = cellFromIndex(m, cell);
+    return true;
+}
+
+// check and do the players move, games with a sink walk it so every stair and pole can be told
+bool isPlayerMoved(Game *g, Move *move)
+{
+    PROBE(PROBE_PLAYER_MOVED);
+    if (g->sink || !g->maze->stepTable || move->dir == NO_CHANGE)
+    {
+        return walkPlayerMove(g, move);
+    }
+    return jumpPlayerMove(g, move);
+}
+
 // ----------------------------------------IMPLIMETATION OF A SINGLE TURN OF A PLAYER---------------------------------------
-void playerTurn(Player *player)
+void playerTurn(Game *g, int p)
 {
+    PROBE(PROBE_PLAYER_TURN);
+    Players *ps = &g->players;
     // check if poisoned
-    if (player->status == POISONED)
+    if (ps->status[p] == POISONED)
     {
         // check if food poisoning still affect
-        if (player->throwsLeftInStatus > 0)
+        if (ps->throwsLeftInStatus[p] > 0)
         {
-            printf("%c is still food poisoned and misses the turn.\n", player->name);
-            player->throwsLeftInStatus--;
+            EMIT(g, {.kind = EVENT_POISON_WAIT, .player = p});
+            ps->throwsLeftInStatus[p]--;
         }
         else
         {
-            struct BawanaCell bawana = getRandomBawanaCell();
-            printf("%c is now fit to proceed from the food poisoning episode and now placed on a %s cell and the effects take place.\n",
-                   player->name, stringBawanaEffects[bawana.type]);
-            applyBawanaEffect(player, &bawana);
+            struct BawanaCell bawana = getRandomBawanaCell(g);
+            EMIT(g, {.kind = EVENT_POISON_OVER, .player = p, .value = bawana.type});
+            applyBawanaEffect(g, p, &bawana);
         }
-        player->throwsCount++;
+        ps->throwsCount[p]++;
         return;
     }
 
     Move move;
 
     // roll movement dice
-    int movementDice = rollMovementDice();
+    int movementDice = rollMovementDice(g);
 
     // increase throw count and deduct mp
-    player->movementPoints -= 2;
-    player->throwsCount++;
+    ps->movementPoints[p] -= 2;
+    ps->throwsCount[p]++;
 
     // roll direction dice if possible
-    Direction dir = player->dir;
+    Direction dir = ps->dir[p];
     bool isDirectionDiceRoll = false;
-    if (player->status != STARTING_AREA && player->throwsCount % 4 == 0)
+    if (ps->status[p] != STARTING_AREA && ps->throwsCount[p] % 4 == 0)
     {
-        dir = rollDirectionDice();
-        player->dir = dir == NO_CHANGE ? player->dir : dir;
+        dir = rollDirectionDice(g);
+        ps->dir[p] = dir == NO_CHANGE ? ps->dir[p] : dir;
         isDirectionDiceRoll = true;
     }
 
     // applying necessary effects to the move according to player's status
-    if (player->status == DISORIENTED)
+    if (ps->status[p] == DISORIENTED)
     {
-        if (player->throwsLeftInStatus > 0)
+        if (ps->throwsLeftInStatus[p] > 0)
         {
-            dir = rollDirectionDice();
-            printf("%c rolls and %d on the movement dice and is disoriented and move in the %s.\n", player->name, movementDice, dir == NO_CHANGE ? stringDirections[player->dir] : stringDirections[dir]);
-            player->throwsLeftInStatus--;
+            dir = rollDirectionDice(g);
+            EMIT(g, {.kind = EVENT_DISORIENTED_ROLL, .player = p, .dice = movementDice, .dir = dir == NO_CHANGE ? ps->dir[p] : dir});
+            ps->throwsLeftInStatus[p]--;
         }
         else
         {
-            printf("%c has recovered from disorientation.\n", player->name);
-            player->status = IN_MAZE;
+            EMIT(g, {.kind = EVENT_DISORIENTED_OVER, .player = p});
+            ps->status[p] = IN_MAZE;
         }
-        move = (Move){player->name, movementDice, dir, player->currentCell, 0, 1, ""};
+        move = (Move){p, movementDice, dir, ps->currentCell[p], 0, 1};
     }
-    else if (player->status == TRIGGERED)
+    else if (ps->status[p] == TRIGGERED)
     {
-        if (player->throwsLeftInStatus > 0)
+        if (ps->throwsLeftInStatus[p] > 0)
         {
-            printf("%c is triggered and rolls and %d on the movement dice and move in the %s and moving %d cells.\n", player->name, movementDice, stringDirections[dir], movementDice * 2);
+            EMIT(g, {.kind = EVENT_TRIGGERED_ROLL, .player = p, .dice = movementDice, .dir = dir, .steps = movementDice * 2});
             movementDice *= 2;
-            player->throwsLeftInStatus--;
+            ps->throwsLeftInStatus[p]--;
         }
         else
         {
-            printf("%c has recovered from triggered status.\n", player->name);
-            player->status = IN_MAZE;
+            EMIT(g, {.kind = EVENT_TRIGGERED_OVER, .player = p});
+            ps->status[p] = IN_MAZE;
         }
-        move = (Move){player->name, movementDice, dir, player->currentCell, 0, 1, ""};
+        move = (Move){p, movementDice, dir, ps->currentCell[p], 0, 1};
     }
-    else if (player->status == STARTING_AREA)
+    else if (ps->status[p] == STARTING_AREA)
     {
         if (movementDice == 6)
         {
-            player->status = IN_MAZE;
-            printf("%c is at the starting area and rolls 6 on the movement dice and is placed on his entry cell of the maze.\n", player->name);
-            move = (Move){player->name, 1, dir, player->currentCell, 0, 1, ""};
+            ps->status[p] = IN_MAZE;
+            EMIT(g, {.kind = EVENT_ENTER_MAZE, .player = p});
+            move = (Move){p, 1, dir, ps->currentCell[p], 0, 1};
         }
         else
         {
-            printf("%c is at the starting area and rolls %d on the movement dice cannot enter the maze.\n", player->name, movementDice);
+            EMIT(g, {.kind = EVENT_STAY_IN_START, .player = p, .dice = movementDice});
             return;
         }
     }
     else
     {
-        move = (Move){player->name, movementDice, dir, player->currentCell, 0, 1, ""};
+        move = (Move){p, movementDice, dir, ps->currentCell[p], 0, 1};
     }
 
     // move player if possible
-    if (isPlayerMoved(&move))
+    if (isPlayerMoved(g, &move))
     {
         // update player's movement points and current location
-        player->currentCell = move.currentCell;
-        player->movementPoints += move.movementPoints * move.mpMultiplyer;
+        setPlayerCell(g, p, move.currentCell);
+        ps->movementPoints[p] += move.movementPoints * move.mpMultiplyer;
 
-        printf("%s", move.msgBuffer);
+        if (g->winner != NO_WINNER)
+        {
+            return;
+        }
 
         // check for captures
-        hasCapturedPlayer(player->name, player->currentCell);
+        hasCapturedPlayer(g, p, ps->currentCell[p]);
 
-        if (isDirectionDiceRoll)
-        {
-            if (dir == NO_CHANGE)
-            {
-                printf("%c rolls and %d on the movement dice and %s on the direction dice. %c's directions stays same and moves %d cells %s and is now at %s.\n",
-                       player->name, movementDice, stringDirections[dir], player->name, move.steps, stringDirections[player->dir], cordToString(player->currentCell));
-            }
-            else
-            {
-                printf("%c rolls and %d on the movement dice and %s on the direction dice, changes direction to %s and moves %d cells and is now at %s.\n",
-                       player->name, movementDice, stringDirections[dir], stringDirections[dir], move.steps, cordToString(player->currentCell));
-            }
-        }
-        else
-        {
-            printf("%c rolls and %d on the movement dice and moves %s by %d cells and is now at %s.\n",
-                   player->name, movementDice, stringDirections[dir], move.steps, cordToString(player->currentCell));
-        }
+        EMIT(g, {.kind = EVENT_MOVE, .player = p, .rolled = isDirectionDiceRoll, .dice = movementDice, .dir = dir,
+                 .facing = ps->dir[p], .steps = move.steps, .to = ps->currentCell[p]});
 
         // check player's mp and if  mp <= 0 teleport to bawana
-        if (player->movementPoints <= 0)
+        if (ps->movementPoints[p] <= 0)
         {
-            struct BawanaCell bawana = getRandomBawanaCell();
-            printf("%c movement points are depleted and requires replenishment. Transporting to Bawana.\n", player->name);
-            printf("%c is place on a %s cell and effects take place.\n", player->name, stringBawanaEffects[bawana.type]);
-            applyBawanaEffect(player, &bawana);
+            struct BawanaCell bawana = getRandomBawanaCell(g);
+            EMIT(g, {.kind = EVENT_DEPLETED, .player = p, .value = bawana.type});
+            applyBawanaEffect(g, p, &bawana);
         }
 
         // check if player is back to starting area
-        if (backToStartingArea(player))
+        if (backToStartingArea(g, p))
         {
-            printf("%c is back to starting area. %c send to his starting location - %s and direction change to starting direction - %s. Movement points are not reset.\n",
-                   player->name, player->name, cordToString(player->startCell), stringDirections[player->startDir]);
+            EMIT(g, {.kind = EVENT_BACK_TO_START, .player = p, .to = g->maze->startCells[p], .dir = g->maze->startDirs[p]});
         }
 
-        // print movement point and direction at the end of the move
-        printf("%c moved %d cells that cost %d movement points and is left with %d and is moving in the %s.\n",
-               player->name, move.steps, move.movementPoints, player->movementPoints, stringDirections[player->dir]);
+        // movement points and direction at the end of the move
+        EMIT(g, {.kind = EVENT_MOVE_DONE, .player = p, .steps = move.steps, .value = move.movementPoints,
+                 .mp = ps->movementPoints[p], .dir = ps->dir[p]});
     }
     else
     {
-        if (isDirectionDiceRoll)
-        {
-            if (dir == NO_CHANGE)
-            {
-                printf("%c rolls and %d on the movement dice and %s on the direction dice, direction remains %s and cannot move. Player remains at %s.\n",
-                       player->name, movementDice, stringDirections[dir], stringDirections[player->dir], cordToString(player->currentCell));
-            }
-            else
-            {
-                printf("%c rolls and %d on the movement dice and %s on the direction dice, direction changed to %s but cannot move. Player remains at %s.\n",
-                       player->name, movementDice, stringDirections[dir], stringDirections[dir], cordToString(player->currentCell));
-            }
-        }
-        else
-        {
-            printf("%c rolls and %d on the movement dice and cannot move in the %s. Player remains at %s.\n",
-                   player->name, movementDice, stringDirections[dir], cordToString(player->currentCell));
-        }
+        EMIT(g, {.kind = EVENT_BLOCKED, .player = p, .rolled = isDirectionDiceRoll, .dice = movementDice, .dir = dir,
+                 .facing = ps->dir[p], .to = ps->currentCell[p]});
     }
 }
 
@@ -0,0 +1,212 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// ----------------------------------------INSTRUMENTATION---------------------------------------
+// built with -DSNL_PROFILE every PROBE times the rest of its function, counting calls and a log2 histogram of the
+// time in a block of counters per thread. the blocks are summed for the report at exit. without SNL_PROFILE a
+// PROBE is nothing at all. times include the probes called inside, a turn includes its move
+
+typedef enum
+{
+    PROBE_LOAD_STAIRS,
+    PROBE_LOAD_POLES,
+    PROBE_LOAD_WALLS,
+    PROBE_MOVEMENT_POINTS,
+    PROBE_FLAG_REACHABLE,
+    PROBE_DISTANCE_FIELD,
+    PROBE_FLAG_TRACKER,
+    PROBE_PLAYER_TURN,
+    PROBE_PLAYER_MOVED,
+    PROBE_MOVE_PLAYER,
+    PROBE_CAPTURE,
+    NO_PROBES
+} Probe;
+
+const char *probeNames[NO_PROBES] = {"loadStairs", "loadPoles", "loadWalls", "addMovementPointsToCells",
+                                     "isFlagReachable", "buildDistanceField", "updateFlagTracker", "playerTurn",
+                                     "isPlayerMoved", "movePlayer", "hasCapturedPlayer"};
+
+#ifdef SNL_PROFILE
+
+#include <pthread.h>
+#include <time.h>
+
+#ifndef __GNUC__
+#error "SNL_PROFILE needs the cleanup attribute of gcc or clang"
+#endif
+
+#define PROBE_BUCKETS 64 // bucket b holds times below 2^(b+1)
+
+typedef struct ProbeCounters
+{
+    uint64_t calls[NO_PROBES];
+    uint64_t total[NO_PROBES];
+    uint64_t max[NO_PROBES];
+    uint64_t histogram[NO_PROBES][PROBE_BUCKETS];
+    struct ProbeCounters *next; // every thread's block, newest first
+} ProbeCounters;
+
+typedef struct
+{
+    Probe probe;
+    uint64_t start;
+} ProbeScope;
+
+ProbeCounters *probeThreads = NULL;
+pthread_mutex_t probeThreadsLock = PTHREAD_MUTEX_INITIALIZER;
+_Thread_local ProbeCounters *probeCounters = NULL;
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PROBE_UNIT "cycles"
+static inline uint64_t probeNow() { return __builtin_ia32_rdtsc(); }
+#else
+#define PROBE_UNIT "ns"
+static inline uint64_t probeNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+// the calling thread's block, made on its first probe. blocks outlive their threads so the report can sum them
+ProbeCounters *probeThreadCounters()
+{
+    if (!probeCounters)
+    {
+        probeCounters = (ProbeCounters *)calloc(1, sizeof(ProbeCounters));
+        if (!probeCounters)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+        pthread_mutex_lock(&probeThreadsLock);
+        probeCounters->next = probeThreads;
+        probeThreads = probeCounters;
+        pthread_mutex_unlock(&probeThreadsLock);
+    }
+    return probeCounters;
+}
+
+static inline void probeEnd(ProbeScope *scope)
+{
+    uint64_t time = probeNow() - scope->start;
+    ProbeCounters *c = probeThreadCounters();
+    c->calls[scope->probe]++;
+    c->total[scope->probe] += time;
+    c->max[scope->probe] = time > c->max[scope->probe] ? time : c->max[scope->probe];
+    c->histogram[scope->probe][time ? 63 - __builtin_clzll(time) : 0]++;
+}
+
+#define PROBE(p) ProbeScope probeScope_ __attribute__((cleanup(probeEnd))) = {p, probeNow()}
+
+#else
+
+#define PROBE(p)
+
+#endif
+
+// ----------------------------------------PROFILE REPORT---------------------------------------
+
+const char *profileJsonPath = NULL; // NULL prints the report as text
+
+#ifdef SNL_PROFILE
+
+// upper bound of the bucket the given share of the calls falls in
+uint64_t probePercentile(const uint64_t *histogram, uint64_t calls, double share)
+{
+    uint64_t seen = 0;
+    for (int b = 0; b < PROBE_BUCKETS; b++)
+    {
+        seen += histogram[b];
+        if (seen > 0 && seen >= share * calls)
+        {
+            return b == 63 ? UINT64_MAX : 2ull << b;
+        }
+    }
+    return 0;
+}
+
+void writeProfileReport()
+{
+    ProbeCounters sum = {0};
+    int threads = 0;
+    pthread_mutex_lock(&probeThreadsLock);
+    for (const ProbeCounters *c = probeThreads; c; c = c->next, threads++)
+    {
+        for (int p = 0; p < NO_PROBES; p++)
+        {
+            sum.calls[p] += c->calls[p];
+            sum.total[p] += c->total[p];
+            sum.max[p] = c->max[p] > sum.max[p] ? c->max[p] : sum.max[p];
+            for (int b = 0; b < PROBE_BUCKETS; b++)
+            {
+                sum.histogram[p][b] += c->histogram[p][b];
+            }
+        }
+    }
+    pthread_mutex_unlock(&probeThreadsLock);
+
+    if (!profileJsonPath)
+    {
+        printf("\nProfile in %s over %d threads, times include the probes called inside:\n", PROBE_UNIT, threads);
+        printf("  %-26s %12s %16s %12s %12s %12s %14s\n", "probe", "calls", "total", "mean", "p50 below", "p99 below", "max");
+        for (int p = 0; p < NO_PROBES; p++)
+        {
+            if (sum.calls[p])
+            {
+                printf("  %-26s %12llu %16llu %12.1f %12llu %12llu %14llu\n", probeNames[p], (unsigned long long)sum.calls[p],
+                       (unsigned long long)sum.total[p], (double)sum.total[p] / sum.calls[p],
+                       (unsigned long long)probePercentile(sum.histogram[p], sum.calls[p], 0.5),
+                       (unsigned long long)probePercentile(sum.histogram[p], sum.calls[p], 0.99), (unsigned long long)sum.max[p]);
+            }
+        }
+        return;
+    }
+
+    FILE *file = fopen(profileJsonPath, "w");
+    if (!file)
+    {
+        printf("\nError: Could not write %s\n", profileJsonPath);
+        return;
+    }
+    fprintf(file, "{\n  \"unit\": \"%s\",\n  \"threads\": %d,\n  \"probes\": [", PROBE_UNIT, threads);
+    for (int p = 0; p < NO_PROBES; p++)
+    {
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"calls\": %llu, \"total\": %llu, \"max\": %llu, \"histogram\": [", p ? "," : "",
+                probeNames[p], (unsigned long long)sum.calls[p], (unsigned long long)sum.total[p], (unsigned long long)sum.max[p]);
+        bool first = true;
+        for (int b = 0; b < PROBE_BUCKETS; b++)
+        {
+            if (sum.histogram[p][b])
+            { // [upper bound, calls] of every bucket that was used
+                fprintf(file, "%s[%llu, %llu]", first ? "" : ", ", b == 63 ? (unsigned long long)UINT64_MAX : 2ull << b,
+                        (unsigned long long)sum.histogram[p][b]);
+                first = false;
+            }
+        }
+        fprintf(file, "]}");
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+}
+
+#else
+
+void writeProfileReport() { printf("\nNo profile: this build has no instrumentation, build it with -DSNL_PROFILE.\n"); }
+
+#endif
+
+// report at exit, as text or as JSON into the given file
+void requestProfileReport(const char *jsonPath)
+{
+    profileJsonPath = jsonPath;
+    atexit(writeProfileReport);
+}
+
+#endif
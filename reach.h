@@ -0,0 +1,649 @@
+#ifndef REACH_H
+#define REACH_H
+
+#include "play.h"
+
+// ----------------------------------------FLOOD FILL---------------------------------------
+// reachability on the packed walkable rows. a row is filled left and right with a handful of shifts, rows are
+// swept top to bottom and back until nothing changes, then stairs and poles carry reached cells to other floors.
+// a bitboard of reached cells is laid out like Maze.walkable, [floor][width][rowWords]
+
+// spread reached bits towards higher cells through open bits (Kogge-Stone fill)
+uint64_t fillHigher(uint64_t gen, uint64_t open)
+{
+    gen |= open & (gen << 1);
+    open &= open << 1;
+    gen |= open & (gen << 2);
+    open &= open << 2;
+    gen |= open & (gen << 4);
+    open &= open << 4;
+    gen |= open & (gen << 8);
+    open &= open << 8;
+    gen |= open & (gen << 16);
+    open &= open << 16;
+    gen |= open & (gen << 32);
+    return gen;
+}
+
+// spread reached bits towards lower cells through open bits
+uint64_t fillLower(uint64_t gen, uint64_t open)
+{
+    gen |= open & (gen >> 1);
+    open &= open >> 1;
+    gen |= open & (gen >> 2);
+    open &= open >> 2;
+    gen |= open & (gen >> 4);
+    open &= open >> 4;
+    gen |= open & (gen >> 8);
+    open &= open >> 8;
+    gen |= open & (gen >> 16);
+    open &= open >> 16;
+    gen |= open & (gen >> 32);
+    return gen;
+}
+
+// pull in the reached cells of the rows above and below row w, then fill the row, returns true if it grew.
+// reach and open point at the first row of a floor
+bool spreadRow(const Maze *m, uint64_t *reach, const uint64_t *open, int w)
+{
+    uint64_t *row = reach + (size_t)w * m->rowWords;
+    const uint64_t *openRow = open + (size_t)w * m->rowWords;
+    bool grew = false;
+
+    for (int i = 0; i < m->rowWords; i++)
+    {
+        uint64_t bits = row[i];
+        if (w > 0)
+        {
+            bits |= row[i - m->rowWords] & openRow[i];
+        }
+        if (w + 1 < m->width)
+        {
+            bits |= row[i + m->rowWords] & openRow[i];
+        }
+        grew = grew || bits != row[i];
+        row[i] = bits;
+    }
+
+    bool carried = true;
+    while (carried) // rows longer than 64 cells carry the fill over word boundaries
+    {
+        carried = false;
+        for (int i = 0; i < m->rowWords; i++)
+        {
+            uint64_t bits = fillHigher(row[i], openRow[i]) | fillLower(row[i], openRow[i]);
+            grew = grew || bits != row[i];
+            row[i] = bits;
+        }
+        for (int i = 0; i + 1 < m->rowWords; i++)
+        {
+            uint64_t up = (row[i] >> 63) & openRow[i + 1] & ~row[i + 1];
+            uint64_t down = (row[i + 1] & 1) & (openRow[i] >> 63) & ~(row[i] >> 63);
+            row[i + 1] |= up;
+            row[i] |= down << 63;
+            carried = carried || up || down;
+        }
+    }
+    return grew;
+}
+
+// flood a floor until no row grows any more
+void floodFloor(const Maze *m, uint64_t *reach, const uint64_t *open)
+{
+    bool grew = true;
+    while (grew)
+    {
+        grew = false;
+        for (int w = 0; w < m->width; w++)
+        {
+            grew = spreadRow(m, reach, open, w) || grew;
+        }
+        for (int w = m->width - 1; w >= 0; w--)
+        {
+            grew = spreadRow(m, reach, open, w) || grew;
+        }
+    }
+}
+
+// mark where a reached stair or pole cell leads, returns true if a new cell was reached
+bool crossFloors(const Game *g, uint64_t *reach, bool *dirty)
+{
+    const Maze *m = g->maze;
+    bool added = false;
+
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        const struct Stair *stair = &m->stairs[i];
+        CellCord ends[2] = {{stair->startFloor, stair->startBlockWidth, stair->startBlockLength},
+                            {stair->endFloor, stair->endBlockWidth, stair->endBlockLength}};
+        for (int e = 0; e < 2; e++)
+        {
+            CellCord to = ends[e];
+            Cell cell = getNextCell(m, to);
+            // a later object may have overwritten this end, the cell decides which object is taken
+            if (cellTypeOf(cell) != STAIR_CELL || cellIdOf(cell) != i || !rowBit(reach + rowOffset(m, to.floor, to.width), to.length))
+            {
+                continue;
+            }
+            if (takeStair(g, &to, i) && !rowBit(reach + rowOffset(m, to.floor, to.width), to.length))
+            {
+                setRowBit(reach + rowOffset(m, to.floor, to.width), to.length);
+                dirty[to.floor] = true;
+                added = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < m->no_Poles; i++)
+    {
+        const struct Pole *pole = &m->poles[i];
+        for (int f = pole->startFloor + 1; f <= pole->endFloor; f++)
+        {
+            CellCord to = {f, pole->widthCell, pole->lengthCell};
+            Cell cell = getNextCell(m, to);
+            if (cellTypeOf(cell) != POLE_CELL || cellIdOf(cell) != i || !rowBit(reach + rowOffset(m, f, to.width), to.length))
+            {
+                continue;
+            }
+            if (takePole(m, &to, i) && !rowBit(reach + rowOffset(m, to.floor, to.width), to.length))
+            {
+                setRowBit(reach + rowOffset(m, to.floor, to.width), to.length);
+                dirty[to.floor] = true;
+                added = true;
+            }
+        }
+    }
+    return added;
+}
+
+// fill the reach bitboard with every cell reachable from start under the game's current stair directions
+void floodFromCell(const Game *g, CellCord start, uint64_t *reach)
+{
+    const Maze *m = g->maze;
+    bool *dirty = (bool *)calloc(m->floors, sizeof(bool));
+    if (!dirty)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    memset(reach, 0, rowOffset(m, m->floors, 0) * sizeof(uint64_t));
+    setRowBit(reach + rowOffset(m, start.floor, start.width), start.length);
+    dirty[start.floor] = true;
+
+    do
+    {
+        for (int f = 0; f < m->floors; f++)
+        {
+            if (dirty[f])
+            {
+                floodFloor(m, reach + rowOffset(m, f, 0), m->walkable + rowOffset(m, f, 0));
+                dirty[f] = false;
+            }
+        }
+    } while (crossFloors(g, reach, dirty));
+    free(dirty);
+}
+
+// check if the flag can be reached from a cell, same answer as bfsFlagReachable
+bool isFlagReachable(const Game *g, CellCord start)
+{
+    PROBE(PROBE_FLAG_REACHABLE);
+    const Maze *m = g->maze;
+    uint64_t *reach = (uint64_t *)malloc(rowOffset(m, m->floors, 0) * sizeof(uint64_t));
+    if (!reach)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    floodFromCell(g, walkingCell(m, start), reach);
+    CellCord flag = m->Flag;
+    bool found = rowBit(reach + rowOffset(m, flag.floor, flag.width), flag.length);
+    free(reach);
+    return found;
+}
+
+// ----------------------------------------DISTANCE FIELD---------------------------------------
+// one reverse BFS from the flag gives every cell's distance to it, so "can X reach the flag" and "how far is X"
+// are lookups. a distance counts the same moves as the searches above: a step to a neighbour cell, or a stair
+// or pole ride, or being put out of Bawana onto its entry. it is only valid for the stair directions it was built with.
+
+#define DIST_UNREACHABLE -1
+
+typedef struct
+{
+    const Maze *maze;
+    int *dist; // [cell index], DIST_UNREACHABLE if the flag can not be reached from the cell
+} DistanceField;
+
+void initDistanceField(DistanceField *field, const Maze *m)
+{
+    field->maze = m;
+    field->dist = (int *)malloc(m->noCells * sizeof(int));
+    if (!field->dist)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+}
+
+void freeDistanceField(DistanceField *field)
+{
+    free(field->dist);
+    field->dist = NULL;
+}
+
+// most stair and pole rides a maze can have, one from each stair end and one from each upper pole cell
+int maxRides(const Maze *m)
+{
+    int count = 2 * m->no_Stairs;
+    for (int i = 0; i < m->no_Poles; i++)
+    {
+        count += m->poles[i].endFloor - m->poles[i].startFloor;
+    }
+    return count;
+}
+
+// add the reverse of a stair or pole ride, from -> to becomes an edge into "from" listed under "to"
+void addReverseEdge(const Maze *m, int *head, int *next, int *from, int *count, CellCord src, CellCord dest)
+{
+    if (isSameCord(src, dest))
+    {
+        return;
+    }
+    from[*count] = cellIndex(m, src);
+    next[*count] = head[cellIndex(m, dest)];
+    head[cellIndex(m, dest)] = (*count)++;
+}
+
+// distances of every cell to the flag under the game's current stair directions
+void buildDistanceField(const Game *g, DistanceField *field)
+{
+    PROBE(PROBE_DISTANCE_FIELD);
+    const Maze *m = g->maze;
+    int maxEdges = maxRides(m) + m->no_BawanaCells;
+
+    int *queue = (int *)malloc(m->noCells * sizeof(int));
+    int *head = (int *)malloc(m->noCells * sizeof(int));
+    int *next = (int *)malloc((maxEdges + 1) * sizeof(int));
+    int *from = (int *)malloc((maxEdges + 1) * sizeof(int));
+    if (!queue || !head || !next || !from)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    // stair and pole rides under the current directions, listed by the cell they lead to
+    int edges = 0;
+    for (int c = 0; c < m->noCells; c++)
+    {
+        head[c] = -1;
+        field->dist[c] = DIST_UNREACHABLE;
+    }
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        const struct Stair *stair = &m->stairs[i];
+        CellCord ends[2] = {{stair->startFloor, stair->startBlockWidth, stair->startBlockLength},
+                            {stair->endFloor, stair->endBlockWidth, stair->endBlockLength}};
+        for (int e = 0; e < 2; e++)
+        {
+            CellCord to = ends[e];
+            Cell cell = getNextCell(m, to);
+            if (cellTypeOf(cell) == STAIR_CELL && cellIdOf(cell) == i && takeStair(g, &to, i))
+            {
+                addReverseEdge(m, head, next, from, &edges, ends[e], to);
+            }
+        }
+    }
+    for (int i = 0; i < m->no_Poles; i++)
+    {
+        const struct Pole *pole = &m->poles[i];
+        for (int f = pole->startFloor + 1; f <= pole->endFloor; f++)
+        {
+            CellCord at = {f, pole->widthCell, pole->lengthCell};
+            CellCord to = at;
+            Cell cell = getNextCell(m, at);
+            if (cellTypeOf(cell) == POLE_CELL && cellIdOf(cell) == i && takePole(m, &to, i))
+            {
+                addReverseEdge(m, head, next, from, &edges, at, to);
+            }
+        }
+    }
+
+    // a player in Bawana gets out by being put on its entry
+    for (int i = 0; i < m->no_BawanaCells; i++)
+    {
+        addReverseEdge(m, head, next, from, &edges, m->bawanaCells[i].cellCoord, BawanaEntry);
+    }
+
+    int front = 0, rear = 0;
+    queue[rear++] = cellIndex(m, m->Flag);
+    field->dist[cellIndex(m, m->Flag)] = 0;
+
+    while (front < rear)
+    {
+        int curr = queue[front++];
+        CellCord cell = cellFromIndex(m, curr);
+        int dist = field->dist[curr] + 1;
+
+        // a neighbour can step onto this cell only if it is not blocked, and walls and empty cells hold no one
+        if (!isBlockedCell(m, cell))
+        {
+            for (Direction d = NORTH; d <= WEST; d++)
+            {
+                CellCord prev = getNextCellCoord(cell, d);
+                if (isValidCordinates(m, prev) && !isBlockedCell(m, prev) && field->dist[cellIndex(m, prev)] == DIST_UNREACHABLE)
+                {
+                    field->dist[cellIndex(m, prev)] = dist;
+                    queue[rear++] = cellIndex(m, prev);
+                }
+            }
+        }
+
+        for (int e = head[curr]; e != -1; e = next[e])
+        {
+            if (field->dist[from[e]] == DIST_UNREACHABLE)
+            {
+                field->dist[from[e]] = dist;
+                queue[rear++] = from[e];
+            }
+        }
+    }
+
+    free(queue);
+    free(head);
+    free(next);
+    free(from);
+}
+
+// moves from a cell to the flag, DIST_UNREACHABLE if there is no way
+int flagDistance(const DistanceField *field, CellCord cell) { return field->dist[cellIndex(field->maze, cell)]; }
+
+bool isFlagReachableFrom(const DistanceField *field, CellCord cell) { return flagDistance(field, cell) != DIST_UNREACHABLE; }
+
+// ----------------------------------------FLAG REACHABILITY ACROSS STAIR FLIPS---------------------------------------
+// walking regions never change, only the stair edges between them do. a player can reach the flag if its region
+// can reach the flag's region in the small graph of regions joined by stair and pole rides. after a flip only
+// the changed stairs are looked at, and the region graph is searched again only if one of them can change an answer.
+
+typedef struct RegionEdge RegionEdge;
+
+// region edges a stair gives under a direction, at most two
+int stairRegionEdges(const Maze *m, int i, StairDirection dir, RegionEdge edges[2])
+{
+    struct StairLink link = m->stairLinks[i];
+    int count = 0;
+
+    if (link.rides[dir] & RIDE_UP)
+    {
+        edges[count++] = (RegionEdge){link.startRegion, link.endRegion};
+    }
+    if (link.rides[dir] & RIDE_DOWN)
+    {
+        edges[count++] = (RegionEdge){link.endRegion, link.startRegion};
+    }
+    return count;
+}
+
+// search the region graph backwards from the flag's region
+void searchFlagRegions(Game *g)
+{
+    const Maze *m = g->maze;
+    FlagTracker *t = &g->tracker;
+    RegionEdge *edges = t->edges;
+    int *head = t->edgeHead;
+    int *next = t->edgeNext;
+    int *queue = t->queue;
+    int flagRegion = m->region[cellIndex(m, m->Flag)];
+    t->searches++;
+
+    if (m->no_Regions <= 64)
+    {
+        // few regions: keep the reached ones in a single word and pass over the rides until nothing is added
+        uint64_t reach = (uint64_t)1 << flagRegion, before;
+        do
+        {
+            before = reach;
+            for (int i = 0; i < m->no_Stairs; i++)
+            {
+                struct StairLink link = m->stairLinks[i];
+                uint64_t rides = link.rides[t->trackedDirs[i]];
+                reach |= ((reach >> link.endRegion) & rides & RIDE_UP) << link.startRegion;
+                reach |= ((reach >> link.startRegion) & (rides >> 1) & 1) << link.endRegion;
+            }
+            for (int e = 0; e < m->no_PoleEdges; e++)
+            {
+                reach |= ((reach >> m->poleEdges[e].to) & 1) << m->poleEdges[e].from;
+            }
+        } while (reach != before);
+
+        for (int r = 0; r < m->no_Regions; r++)
+        {
+            t->regionReachesFlag[r] = (reach >> r) & 1;
+        }
+        return;
+    }
+
+    int count = 0;
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        count += stairRegionEdges(m, i, t->trackedDirs[i], &edges[count]);
+    }
+    memcpy(&edges[count], m->poleEdges, m->no_PoleEdges * sizeof(RegionEdge));
+    count += m->no_PoleEdges;
+
+    // edges listed under the region they lead to
+    for (int r = 0; r < m->no_Regions; r++)
+    {
+        head[r] = -1;
+        t->regionReachesFlag[r] = false;
+    }
+    for (int e = 0; e < count; e++)
+    {
+        next[e] = head[edges[e].to];
+        head[edges[e].to] = e;
+    }
+
+    int front = 0, rear = 0;
+    queue[rear++] = flagRegion;
+    t->regionReachesFlag[flagRegion] = true;
+    while (front < rear)
+    {
+        int r = queue[front++];
+        for (int e = head[r]; e != -1; e = next[e])
+        {
+            if (!t->regionReachesFlag[edges[e].from])
+            {
+                t->regionReachesFlag[edges[e].from] = true;
+                queue[rear++] = edges[e].from;
+            }
+        }
+    }
+}
+
+void initFlagTracker(Game *g)
+{
+    FlagTracker *t = &g->tracker;
+    t->regionReachesFlag = (bool *)malloc((g->maze->no_Regions + 1) * sizeof(bool));
+    t->trackedDirs = (StairDirection *)malloc((g->maze->no_Stairs + 1) * sizeof(StairDirection));
+    t->edges = (RegionEdge *)malloc((maxRides(g->maze) + 1) * sizeof(RegionEdge));
+    t->edgeHead = (int *)malloc((g->maze->no_Regions + 1) * sizeof(int));
+    t->edgeNext = (int *)malloc((maxRides(g->maze) + 1) * sizeof(int));
+    t->queue = (int *)malloc((g->maze->no_Regions + 1) * sizeof(int));
+    if (!t->regionReachesFlag || !t->trackedDirs || !t->edges || !t->edgeHead || !t->edgeNext || !t->queue)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+}
+
+void freeFlagTracker(Game *g)
+{
+    free(g->tracker.regionReachesFlag);
+    free(g->tracker.trackedDirs);
+    free(g->tracker.edges);
+    free(g->tracker.edgeHead);
+    free(g->tracker.edgeNext);
+    free(g->tracker.queue);
+    g->tracker = (FlagTracker){0};
+}
+
+// start tracking from the game's current stair directions
+void resetFlagTracker(Game *g)
+{
+    FlagTracker *t = &g->tracker;
+    memcpy(t->trackedDirs, g->stairDirs, g->maze->no_Stairs * sizeof(StairDirection));
+    t->searches = 0;
+    t->unwinnableRounds = 0;
+    t->unwinnableStretches = 0;
+    t->cutOff = false;
+    searchFlagRegions(g);
+}
+
+// bring the tracker up to date after changeStairDirection, looking only at the stairs that changed
+void updateFlagTracker(Game *g)
+{
+    PROBE(PROBE_FLAG_TRACKER);
+    const Maze *m = g->maze;
+    FlagTracker *t = &g->tracker;
+    int search = 0;
+
+    if (m->no_Regions <= 64)
+    {
+        // the word search costs less than checking every changed stair
+        memcpy(t->trackedDirs, g->stairDirs, m->no_Stairs * sizeof(StairDirection));
+        searchFlagRegions(g);
+        return;
+    }
+
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        struct StairLink link = m->stairLinks[i];
+        int before = link.rides[t->trackedDirs[i]];
+        int after = link.rides[g->stairDirs[i]];
+        int startReaches = t->regionReachesFlag[link.startRegion];
+        int endReaches = t->regionReachesFlag[link.endRegion];
+        t->trackedDirs[i] = g->stairDirs[i];
+
+        // a lost ride matters only if it left a region that reached the flag,
+        // a new ride only if it leads from a cut off region into one that reaches the flag.
+        // kept as bit operations, flips are frequent and the branches would be unpredictable
+        int lost = before & ~after;
+        int gained = after & ~before;
+        search |= lost & (startReaches * RIDE_UP | endReaches * RIDE_DOWN);
+        search |= gained & ((endReaches & !startReaches) * RIDE_UP | (startReaches & !endReaches) * RIDE_DOWN);
+    }
+
+    if (search)
+    {
+        searchFlagRegions(g);
+    }
+}
+
+bool canReachFlag(const Game *g, CellCord cell)
+{
+    int region = g->maze->region[cellIndex(g->maze, walkingCell(g->maze, cell))];
+    return region != -1 && g->tracker.regionReachesFlag[region];
+}
+
+// count the round if some player can not reach the flag with the current stair directions
+void trackUnwinnableRound(Game *g)
+{
+    FlagTracker *t = &g->tracker;
+    bool cutOff = false;
+    for (int p = 0; p < g->players.count; p++)
+    {
+        if (!canReachFlag(g, g->players.currentCell[p]))
+        {
+            cutOff = true;
+            if (!t->cutOff)
+            {
+                EMIT(g, {.kind = EVENT_CUT_OFF, .player = p});
+            }
+        }
+    }
+    if (cutOff)
+    {
+        t->unwinnableRounds++;
+        t->unwinnableStretches += !t->cutOff;
+    }
+    t->cutOff = cutOff;
+}
+
+// ----------------------------------------BFS REFERENCE---------------------------------------
+// cell by cell search, kept to cross check the flood fill
+bool bfsFlagReachable(const Game *g, CellCord start)
+{
+    const Maze *m = g->maze;
+    // BFS queue: every cell is queued at most once
+    CellCord *queue = (CellCord *)malloc(m->noCells * sizeof(CellCord));
+    bool *visited = (bool *)calloc(m->noCells, sizeof(bool));
+    int front = 0, rear = 0;
+    bool found = false;
+    if (!queue || !visited)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+
+    start = walkingCell(m, start);
+    queue[rear++] = start;
+    visited[cellIndex(m, start)] = true;
+
+    while (front < rear)
+    {
+        CellCord curr = queue[front++];
+
+        if (isSameCord(curr, g->maze->Flag))
+        {
+            found = true; // Flag reached
+            break;
+        }
+
+        // Check neighbors: N, E, S, W
+        Direction dirs[] = {NORTH, EAST, SOUTH, WEST};
+        for (int d = 0; d < 4; d++)
+        {
+            CellCord next = getNextCellCoord(curr, dirs[d]);
+            if (isValidCordinates(m, next) && !isBlockedCell(g->maze, next) && !visited[cellIndex(m, next)])
+            {
+                visited[cellIndex(m, next)] = true;
+                queue[rear++] = next;
+            }
+        }
+
+        // Handle stairs if on a stair cell
+        Cell cell = m->cells[cellIndex(m, curr)];
+        if (cellTypeOf(cell) == STAIR_CELL)
+        {
+            CellCord stairEnd = curr; // Temp
+            if (takeStair(g, &stairEnd, cellIdOf(cell)))
+            { // Reuse takeStair to get end
+                if (!visited[cellIndex(m, stairEnd)])
+                {
+                    visited[cellIndex(m, stairEnd)] = true;
+                    queue[rear++] = stairEnd;
+                }
+            }
+        }
+
+        // Handle poles if on a pole cell (down only, as per game logic)
+        if (cellTypeOf(cell) == POLE_CELL)
+        {
+            CellCord poleStart = curr; // Temp
+            if (takePole(g->maze, &poleStart, cellIdOf(cell)))
+            {
+                if (!visited[cellIndex(m, poleStart)])
+                {
+                    visited[cellIndex(m, poleStart)] = true;
+                    queue[rear++] = poleStart;
+                }
+            }
+        }
+    }
+    free(queue);
+    free(visited);
+    return found;
+}
+
+#endif
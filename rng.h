@@ -0,0 +1,71 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// ----------------------------------------COUNTER BASED RANDOM NUMBERS---------------------------------------
+// every value is a pure function of (key, counter), so a stream needs no shared state and any game can be
+// replayed on its own from its seed and game index, no matter what ran before it or on which thread
+
+#define RNG_MAZE_STREAM UINT64_MAX // stream used to shuffle movement points and Bawana, games use their index
+#define RNG_PLAYER_STREAM (UINT64_MAX - 1) // stream the start cells of the players after the first three are drawn from
+
+typedef struct
+{
+    uint64_t key;     // fixed per stream, derived from seed and stream index
+    uint64_t counter; // number of values drawn so far
+} Rng;
+
+// splitmix64 finalizer, a strong 64 bit mixing function
+uint64_t rngMix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// start the stream of a game (or RNG_MAZE_STREAM) for the given seed
+void rngInit(Rng *rng, uint64_t seed, uint64_t stream)
+{
+    rng->key = rngMix(rngMix(seed) ^ (stream * 0x9E3779B97F4A7C15ull)) | 1; // odd key, so counter * key never repeats
+    rng->counter = 0;
+}
+
+// split an independent stream off rng, so a game can be played on along several branches
+void rngBranch(Rng *rng, uint64_t branch)
+{
+    rng->key = rngMix(rngMix(rng->key ^ rng->counter) ^ (branch * 0x9E3779B97F4A7C15ull)) | 1;
+    rng->counter = 0;
+}
+
+// value number counter of the stream
+uint64_t rngAt(uint64_t key, uint64_t counter)
+{
+    return rngMix(counter * key + key);
+}
+
+uint64_t rngNext(Rng *rng)
+{
+    return rngAt(rng->key, rng->counter++);
+}
+
+// unbiased number in [0, n) using multiply-shift with rejection of the few biased values (Lemire). games roll their
+// dice with it straight from the stream: values mixed ahead into a buffer of 16, in AVX2 lanes, took as long to read
+// back and check as they take to mix here, and whole games played no faster
+uint32_t rngBelow(Rng *rng, uint32_t n)
+{
+    uint64_t m = (uint64_t)(uint32_t)rngNext(rng) * n;
+    uint32_t low = (uint32_t)m;
+    if (low < n)
+    {
+        uint32_t threshold = (uint32_t)-n % n;
+        while (low < threshold)
+        {
+            m = (uint64_t)(uint32_t)rngNext(rng) * n;
+            low = (uint32_t)m;
+        }
+    }
+    return (uint32_t)(m >> 32);
+}
+
+#endif
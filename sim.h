@@ -0,0 +1,1114 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <time.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#include "play.h"
+#include "reach.h"
+#include "snapshot.h"
+#include "output.h"
+
+#define MAX_ROUNDS 100000 // a game still running after this many rounds is counted as unfinished
+#define MAX_THREADS 256
+
+typedef struct
+{
+    int winner; // NO_WINNER if the game was stopped at MAX_ROUNDS
+    int rounds;
+    int unwinnableRounds;    // rounds that started with some player unable to reach the flag
+    int unwinnableStretches; // runs of consecutive such rounds
+    int bawanaVisits;
+} GameResult;
+
+#define STATS_PLAYERS 26 // wins are counted for each of the first players, and for all the others together
+
+typedef struct
+{
+    long games;
+    int players;
+    long wins[STATS_PLAYERS + 1];
+    long unfinished;
+    long long totalRounds;
+    long long unwinnableRounds;
+    long long unwinnableStretches;
+    long gamesWithUnwinnable;
+    long long bawanaVisits;
+} BatchStats;
+
+// ----------------------------------------TIMING---------------------------------------
+
+// wall clock time in seconds
+double nowSeconds()
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// number of cores the runner can spread games over
+int cpuCount()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+// make a directory, it is fine if it is there already
+void makeDirectory(const char *path)
+{
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+// ----------------------------------------GAME LIFECYCLE---------------------------------------
+
+// reset everything a game changes, the shared maze and objects are kept as they are
+void resetGame(Game *g)
+{
+    initPlayers(g);
+    for (int i = 0; i < g->maze->no_Stairs; i++)
+    {
+        g->stairDirs[i] = BI_DIR;
+    }
+    g->gameRound = 0;
+    g->bawanaVisits = 0;
+    g->winner = NO_WINNER;
+    resetFlagTracker(g);
+}
+
+// prepare a game on an already loaded maze, the game's dice come from the stream (seed, gameIndex)
+void initGame(Game *g, const Maze *m, unsigned int seed, long gameIndex)
+{
+    g->maze = m;
+    g->stairDirs = (StairDirection *)malloc(m->no_Stairs * sizeof(StairDirection));
+    if (!g->stairDirs)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    allocatePlayers(&g->players, m);
+    rngInit(&g->rng, seed, (uint64_t)gameIndex);
+    g->sink = NULL;
+    g->script = NULL;
+    initFlagTracker(g);
+    resetGame(g);
+}
+
+void freeGame(Game *g)
+{
+    free(g->stairDirs);
+    g->stairDirs = NULL;
+    freePlayers(&g->players);
+    freeFlagTracker(g);
+}
+
+// whether every player can reach the flag at the start of a game, the game refuses to start otherwise
+bool isFlagReachableFromStarts(const Maze *m, unsigned int seed)
+{
+    Game game;
+    DistanceField field;
+    initGame(&game, m, seed, 0);
+    initDistanceField(&field, m);
+    buildDistanceField(&game, &field);
+    bool reachable = true;
+    for (int p = 0; p < m->no_Players; p++)
+    {
+        reachable &= isFlagReachableFrom(&field, m->startCells[p]);
+    }
+    freeDistanceField(&field);
+    freeGame(&game);
+    return reachable;
+}
+
+// ----------------------------------------SINGLE GAME---------------------------------------
+
+// play on from the game's current round until a player captures the flag or lastRound rounds have been played
+GameResult continueGame(Game *g, int lastRound)
+{
+    while (g->winner == NO_WINNER && g->gameRound < lastRound)
+    {
+        EMIT(g, {.kind = EVENT_ROUND, .value = g->gameRound + 1});
+        trackUnwinnableRound(g);
+        for (int p = 0; p < g->players.count; p++)
+        {
+            EMIT(g, {.kind = EVENT_TURN, .player = p});
+            playerTurn(g, p);
+            if (g->winner != NO_WINNER)
+            {
+                return (GameResult){g->winner, g->gameRound + 1, g->tracker.unwinnableRounds, g->tracker.unwinnableStretches, g->bawanaVisits};
+            }
+        }
+
+        g->gameRound++;
+        if (g->gameRound % 5 == 0)
+        {
+            EMIT(g, {.kind = EVENT_STAIRS_CHANGED});
+            changeStairDirection(g);
+            updateFlagTracker(g);
+        }
+    }
+    return (GameResult){g->winner, g->gameRound + (g->winner != NO_WINNER), g->tracker.unwinnableRounds, g->tracker.unwinnableStretches, g->bawanaVisits};
+}
+
+// play a full game from round 1 until a player captures the flag
+GameResult playGame(Game *g)
+{
+    resetGame(g);
+    return continueGame(g, MAX_ROUNDS);
+}
+
+// ----------------------------------------SAVE AND FORK---------------------------------------
+// the state of a game between two rounds, everything else is in the maze it is played on
+
+#define GAME_STATE_MAGIC "SNLGAME"
+#define GAME_STATE_VERSION 3
+#define PLAYER_ARRAYS 6
+
+// fixed part of a saved game, the player arrays and one byte per stair direction follow it
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t playerSize; // bytes of all player arrays for one player, a build with other types can not read it
+    int32_t noPlayers;   // the maze it is restored on must have the same players, stairs and cells
+    int32_t noStairs;
+    int32_t noCells;
+    int32_t gameRound;
+    int32_t bawanaVisits;
+    int32_t unwinnableRounds;
+    int32_t unwinnableStretches;
+    uint8_t cutOff;
+    int32_t winner;
+    int64_t searches;
+    Rng rng;
+} GameStateHeader;
+
+// the arrays of the players a game changes and the size of their elements, in the order a saved game holds them
+void playerArrays(const Players *ps, void *arrays[PLAYER_ARRAYS], size_t sizes[PLAYER_ARRAYS])
+{
+    void *a[PLAYER_ARRAYS] = {ps->currentCell, ps->movementPoints, ps->dir, ps->status, ps->throwsCount, ps->throwsLeftInStatus};
+    size_t s[PLAYER_ARRAYS] = {sizeof(CellCord), sizeof(int), sizeof(Direction), sizeof(PlayerStatus), sizeof(int), sizeof(int)};
+    memcpy(arrays, a, sizeof(a));
+    memcpy(sizes, s, sizeof(s));
+}
+
+size_t playerStateSize()
+{
+    void *arrays[PLAYER_ARRAYS];
+    size_t sizes[PLAYER_ARRAYS], size = 0;
+    playerArrays(&(Players){0}, arrays, sizes);
+    for (int i = 0; i < PLAYER_ARRAYS; i++)
+    {
+        size += sizes[i];
+    }
+    return size;
+}
+
+size_t gameStateSize(const Game *g) { return sizeof(GameStateHeader) + g->players.count * playerStateSize() + g->maze->no_Stairs; }
+
+// write the state of a game into buffer, which holds gameStateSize bytes
+void saveGameState(const Game *g, void *buffer)
+{
+    GameStateHeader header;
+    memset(&header, 0, sizeof(header)); // the padding is written too, keep it from holding stack garbage
+    memcpy(header.magic, GAME_STATE_MAGIC, sizeof(header.magic));
+    header.version = GAME_STATE_VERSION;
+    header.playerSize = (uint32_t)playerStateSize();
+    header.noPlayers = g->players.count;
+    header.noStairs = g->maze->no_Stairs;
+    header.noCells = g->maze->noCells;
+    header.gameRound = g->gameRound;
+    header.bawanaVisits = g->bawanaVisits;
+    header.unwinnableRounds = g->tracker.unwinnableRounds;
+    header.unwinnableStretches = g->tracker.unwinnableStretches;
+    header.cutOff = g->tracker.cutOff;
+    header.winner = g->winner;
+    header.searches = g->tracker.searches;
+    header.rng = g->rng;
+    memcpy(buffer, &header, sizeof(header));
+
+    uint8_t *at = (uint8_t *)buffer + sizeof(header);
+    void *arrays[PLAYER_ARRAYS];
+    size_t sizes[PLAYER_ARRAYS];
+    playerArrays(&g->players, arrays, sizes);
+    for (int i = 0; i < PLAYER_ARRAYS; i++)
+    {
+        memcpy(at, arrays[i], g->players.count * sizes[i]);
+        at += g->players.count * sizes[i];
+    }
+    uint8_t *dirs = at;
+    for (int i = 0; i < g->maze->no_Stairs; i++)
+    {
+        dirs[i] = (uint8_t)g->stairDirs[i];
+    }
+}
+
+// check every value of a saved state before any of it is put into the game, the cells index the occupancy index
+bool isValidGameState(const Game *g, const GameStateHeader *header, const uint8_t *at)
+{
+    int count = g->players.count;
+    if ((header->winner != NO_WINNER && (header->winner < 0 || header->winner >= count)) || header->gameRound < 0 ||
+        header->bawanaVisits < 0)
+    {
+        return false;
+    }
+
+    // the arrays in playerArrays order: cell, movement points, direction, status, throws, throws left in status
+    void *arrays[PLAYER_ARRAYS];
+    size_t sizes[PLAYER_ARRAYS];
+    const uint8_t *saved[PLAYER_ARRAYS];
+    playerArrays(&g->players, arrays, sizes);
+    for (int i = 0; i < PLAYER_ARRAYS; i++)
+    {
+        saved[i] = at;
+        at += count * sizes[i];
+    }
+    for (int p = 0; p < count; p++)
+    {
+        CellCord cell;
+        Direction dir;
+        PlayerStatus status;
+        int throws, left;
+        memcpy(&cell, saved[0] + p * sizes[0], sizeof(cell));
+        memcpy(&dir, saved[2] + p * sizes[2], sizeof(dir));
+        memcpy(&status, saved[3] + p * sizes[3], sizeof(status));
+        memcpy(&throws, saved[4] + p * sizes[4], sizeof(throws));
+        memcpy(&left, saved[5] + p * sizes[5], sizeof(left));
+        if (!isValidCordinates(g->maze, cell) || (unsigned)dir > WEST || (unsigned)status > TRIGGERED || throws < 0 ||
+            left < 0 || left > 4)
+        {
+            return false;
+        }
+    }
+
+    const uint8_t *stairDirs = at;
+    for (int i = 0; i < g->maze->no_Stairs; i++)
+    {
+        if (stairDirs[i] > BI_DIR)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// put a game set up with initGame back into a saved state, false if it was saved by another build or on another maze
+// or does not hold a state a game can be in. the game is not touched then
+bool restoreGameState(Game *g, const void *buffer, size_t size)
+{
+    GameStateHeader header;
+    if (size < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, buffer, sizeof(header));
+    if (memcmp(header.magic, GAME_STATE_MAGIC, sizeof(header.magic)) != 0 || header.version != GAME_STATE_VERSION ||
+        header.playerSize != playerStateSize() || header.noPlayers != g->players.count || header.noStairs != g->maze->no_Stairs ||
+        header.noCells != g->maze->noCells || size != gameStateSize(g))
+    {
+        return false;
+    }
+
+    if (!isValidGameState(g, &header, (const uint8_t *)buffer + sizeof(header)))
+    {
+        return false;
+    }
+
+    const uint8_t *at = (const uint8_t *)buffer + sizeof(header);
+    void *arrays[PLAYER_ARRAYS];
+    size_t sizes[PLAYER_ARRAYS];
+    playerArrays(&g->players, arrays, sizes);
+    const uint8_t *dirs = at + g->players.count * playerStateSize();
+    for (int i = 0; i < g->maze->no_Stairs; i++)
+    {
+        g->stairDirs[i] = (StairDirection)dirs[i];
+    }
+    unlinkAllPlayers(g);
+    for (int i = 0; i < PLAYER_ARRAYS; i++)
+    {
+        memcpy(arrays[i], at, g->players.count * sizes[i]);
+        at += g->players.count * sizes[i];
+    }
+    linkAllPlayers(g);
+    g->gameRound = header.gameRound;
+    g->bawanaVisits = header.bawanaVisits;
+    g->winner = header.winner;
+    g->rng = header.rng;
+    resetFlagTracker(g); // which regions reach the flag is worked out again, the counters are restored
+    g->tracker.unwinnableRounds = header.unwinnableRounds;
+    g->tracker.unwinnableStretches = header.unwinnableStretches;
+    g->tracker.cutOff = header.cutOff;
+    g->tracker.searches = header.searches;
+    return true;
+}
+
+void saveGameFile(const Game *g, const char *path)
+{
+    size_t size = gameStateSize(g);
+    void *buffer = malloc(size);
+    FILE *file = fopen(path, "wb");
+    if (!buffer || !file)
+    {
+        printf("\nError: Could not write %s\n", path);
+        exit(1);
+    }
+    saveGameState(g, buffer);
+    bool written = fwrite(buffer, 1, size, file) == size;
+    if (fclose(file) != 0 || !written)
+    {
+        printf("\nError: Could not write %s\n", path);
+        exit(1);
+    }
+    free(buffer);
+}
+
+void loadGameFile(Game *g, const char *path)
+{
+    MappedFile file;
+    if (!mapFile(&file, path))
+    {
+        printf("\nError: Could not open %s\n", path);
+        exit(1);
+    }
+    if (!restoreGameState(g, file.data, file.size))
+    {
+        printf("\nError: %s is not a game saved on this maze by this build.\n", path);
+        exit(1);
+    }
+    unmapFile(&file);
+}
+
+// continue from the position of another game on the same maze, into must be set up with initGame on it.
+// only the players, stair directions and dice are copied. branch 0 keeps the dice of from, so into plays on
+// exactly as from would, every other branch rolls dice of its own
+void forkGame(Game *into, const Game *from, uint64_t branch)
+{
+    const Maze *m = from->maze;
+    void *intoArrays[PLAYER_ARRAYS], *fromArrays[PLAYER_ARRAYS];
+    size_t sizes[PLAYER_ARRAYS];
+    playerArrays(&into->players, intoArrays, sizes);
+    playerArrays(&from->players, fromArrays, sizes);
+    unlinkAllPlayers(into);
+    for (int i = 0; i < PLAYER_ARRAYS; i++)
+    {
+        memcpy(intoArrays[i], fromArrays[i], from->players.count * sizes[i]);
+    }
+    linkAllPlayers(into);
+    memcpy(into->stairDirs, from->stairDirs, m->no_Stairs * sizeof(StairDirection));
+    into->gameRound = from->gameRound;
+    into->bawanaVisits = from->bawanaVisits;
+    into->winner = from->winner;
+    into->rng = from->rng;
+    if (branch)
+    {
+        rngBranch(&into->rng, branch);
+    }
+
+    FlagTracker *t = &into->tracker;
+    memcpy(t->regionReachesFlag, from->tracker.regionReachesFlag, m->no_Regions * sizeof(bool));
+    memcpy(t->trackedDirs, from->tracker.trackedDirs, m->no_Stairs * sizeof(StairDirection));
+    t->searches = from->tracker.searches;
+    t->unwinnableRounds = from->tracker.unwinnableRounds;
+    t->unwinnableStretches = from->tracker.unwinnableStretches;
+    t->cutOff = from->tracker.cutOff;
+}
+
+// ----------------------------------------BATCH SIMULATION---------------------------------------
+
+void addGameResult(BatchStats *stats, const Game *g, GameResult result)
+{
+    stats->games++;
+    stats->totalRounds += result.rounds;
+    stats->unwinnableRounds += result.unwinnableRounds;
+    stats->unwinnableStretches += result.unwinnableStretches;
+    stats->gamesWithUnwinnable += result.unwinnableRounds > 0;
+    stats->bawanaVisits += result.bawanaVisits;
+    stats->players = g->players.count;
+    if (result.winner == NO_WINNER)
+    {
+        stats->unfinished++;
+        return;
+    }
+    stats->wins[result.winner < STATS_PLAYERS ? result.winner : STATS_PLAYERS]++;
+}
+
+void mergeBatchStats(BatchStats *into, const BatchStats *from)
+{
+    into->games += from->games;
+    into->unfinished += from->unfinished;
+    into->totalRounds += from->totalRounds;
+    into->unwinnableRounds += from->unwinnableRounds;
+    into->unwinnableStretches += from->unwinnableStretches;
+    into->gamesWithUnwinnable += from->gamesWithUnwinnable;
+    into->bawanaVisits += from->bawanaVisits;
+    into->players = from->players > into->players ? from->players : into->players;
+    for (int i = 0; i <= STATS_PLAYERS; i++)
+    {
+        into->wins[i] += from->wins[i];
+    }
+}
+
+typedef struct
+{
+    const Maze *maze;
+    unsigned int seed;
+    long firstGame; // this worker plays games firstGame, firstGame + stride, ...
+    long stride;
+    long games;     // total games of the whole batch
+    Output *output; // NULL or where ring firstGame takes the games told
+    int *rounds;    // NULL or [game] rounds it lasted, each worker writes its own games
+    BatchStats stats;
+} BatchWorker;
+
+void *batchWorkerRun(void *arg)
+{
+    BatchWorker *worker = (BatchWorker *)arg;
+    Game game;
+    initGame(&game, worker->maze, worker->seed, worker->firstGame);
+    int ring = (int)worker->firstGame;
+    game.sink = outputSink(worker->output, ring);
+
+    for (long i = worker->firstGame; i < worker->games; i += worker->stride)
+    {
+        rngInit(&game.rng, worker->seed, (uint64_t)i); // same dice as replaying game i on its own
+        if (game.sink)
+        {
+            worker->output->rings[ring].game = i;
+        }
+        GameResult result = playGame(&game);
+        addGameResult(&worker->stats, &game, result);
+        if (worker->rounds)
+        {
+            worker->rounds[i] = result.rounds;
+        }
+        outputGameEnd(worker->output, ring, i, result.winner, result.rounds);
+    }
+
+    freeGame(&game);
+    return NULL;
+}
+
+// play independent games spread over the given number of threads, all sharing the read only maze. output is NULL
+// or opened with a ring per thread, rounds is NULL or takes the rounds of every game
+BatchStats runBatch(const Maze *m, unsigned int seed, long games, int threads, Output *output, int *rounds)
+{
+    BatchWorker workers[MAX_THREADS];
+    pthread_t ids[MAX_THREADS];
+    BatchStats total = {0};
+
+    for (int t = 0; t < threads; t++)
+    {
+        workers[t] = (BatchWorker){m, seed, t, threads, games, output, rounds, {0}};
+    }
+    // the calling thread plays the first share itself
+    for (int t = 1; t < threads; t++)
+    {
+        if (pthread_create(&ids[t], NULL, batchWorkerRun, &workers[t]) != 0)
+        {
+            printf("\nError: Could not start simulation thread.\n");
+            exit(1);
+        }
+    }
+    batchWorkerRun(&workers[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        pthread_join(ids[t], NULL);
+    }
+
+    for (int t = 0; t < threads; t++)
+    {
+        mergeBatchStats(&total, &workers[t].stats);
+    }
+    return total;
+}
+
+void printBatchStats(const BatchStats *stats, double elapsed)
+{
+
+    printf("\nBatch of %ld games finished in %.3f s (%.0f games/sec).\n", stats->games, elapsed, elapsed > 0 ? stats->games / elapsed : 0.0);
+    char name[NAME_STR_SIZE];
+    for (int i = 0; i < stats->players && i < STATS_PLAYERS; i++)
+    {
+        printf("  %s won %ld games (%.2f%%)\n", playerName(i, name), stats->wins[i], stats->games ? 100.0 * stats->wins[i] / stats->games : 0.0);
+    }
+    if (stats->players > STATS_PLAYERS)
+    {
+        printf("  the other %d players won %ld games (%.2f%%)\n", stats->players - STATS_PLAYERS, stats->wins[STATS_PLAYERS],
+               stats->games ? 100.0 * stats->wins[STATS_PLAYERS] / stats->games : 0.0);
+    }
+    printf("  unfinished after %d rounds: %ld\n", MAX_ROUNDS, stats->unfinished);
+    printf("  average rounds per game: %.2f\n", stats->games ? (double)stats->totalRounds / stats->games : 0.0);
+    printf("  average Bawana visits per game: %.2f\n", stats->games ? (double)stats->bawanaVisits / stats->games : 0.0);
+    printf("  rounds where some player could not reach the flag: %lld (%.2f%%) in %lld stretches over %ld games\n",
+           stats->unwinnableRounds, stats->totalRounds ? 100.0 * stats->unwinnableRounds / stats->totalRounds : 0.0,
+           stats->unwinnableStretches, stats->gamesWithUnwinnable);
+}
+
+// ----------------------------------------SCALING BENCHMARK---------------------------------------
+
+// run the same batch on 1..maxThreads threads and report the speed up over a single thread
+void runScalingBenchmark(const Maze *m, unsigned int seed, long games, int maxThreads)
+{
+    double singleThread = 0;
+
+    printf("\nScaling benchmark: %ld games per run, 1..%d threads\n", games, maxThreads);
+    printf("  threads      time(s)    games/sec   speedup  efficiency\n");
+    for (int t = 1; t <= maxThreads; t++)
+    {
+        double start = nowSeconds();
+        runBatch(m, seed, games, t, NULL, NULL);
+        double elapsed = nowSeconds() - start;
+        if (t == 1)
+        {
+            singleThread = elapsed;
+        }
+        double speedup = elapsed > 0 ? singleThread / elapsed : 0.0;
+        printf("  %7d  %11.3f  %11.0f  %8.2f  %9.0f%%\n", t, elapsed, elapsed > 0 ? games / elapsed : 0.0, speedup, 100.0 * speedup / t);
+    }
+}
+
+// ----------------------------------------RNG BENCHMARK---------------------------------------
+
+// time bulk dice rolls from libc rand() against a game's counter based stream
+void runRngBenchmark(unsigned int seed, long rolls)
+{
+    volatile long sink = 0; // keeps the loops from being optimized away
+    long sum = 0;
+    Rng rng;
+
+    srand(seed);
+    double start = nowSeconds();
+    for (long i = 0; i < rolls; i++)
+    {
+        sum += rand() % 6 + 1;
+    }
+    double libcTime = nowSeconds() - start;
+    sink = sum;
+
+    sum = 0;
+    rngInit(&rng, seed, 0);
+    start = nowSeconds();
+    for (long i = 0; i < rolls; i++)
+    {
+        sum += rngBelow(&rng, 6) + 1;
+    }
+    double rngTime = nowSeconds() - start;
+    sink = sum;
+
+    (void)sink;
+
+    printf("\nDice benchmark: %ld rolls\n", rolls);
+    printf("  rand() %% 6      %8.2f ns/roll\n", 1e9 * libcTime / rolls);
+    printf("  rngBelow(6)     %8.2f ns/roll  (%.2fx)\n", 1e9 * rngTime / rolls, rngTime > 0 ? libcTime / rngTime : 0.0);
+}
+
+// ----------------------------------------MOVE BENCHMARK---------------------------------------
+
+typedef struct
+{
+    int cell;
+    char dir;
+    char steps;
+} BenchMove;
+
+// time random moves walked step by step against the precomputed table, and check both agree
+void runMoveBenchmark(const Maze *m, unsigned int seed, long moves)
+{
+    Game game;
+    initGame(&game, m, seed, 0);
+    changeStairDirection(&game); // mix of UP, DOWN and BI_DIR stairs
+
+    BenchMove *list = (BenchMove *)malloc(moves * sizeof(BenchMove));
+    if (!list)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (long i = 0; i < moves; i++)
+    {
+        int cell;
+        do
+        {
+            cell = (int)rngBelow(&game.rng, m->noCells);
+        } while (isBlockedCell(m, cellFromIndex(m, cell)));
+        list[i] = (BenchMove){cell, (char)rngBelow(&game.rng, 4), (char)(rngBelow(&game.rng, MAX_MOVE_STEPS) + 1)};
+    }
+
+    long long checksum[2] = {0, 0};
+    double elapsed[2];
+    for (int pass = 0; pass < 2; pass++)
+    {
+        double start = nowSeconds();
+        for (long i = 0; i < moves; i++)
+        {
+            Move move = {0, list[i].steps, (Direction)list[i].dir, cellFromIndex(m, list[i].cell), 0, 1};
+            game.winner = NO_WINNER;
+            bool moved = pass == 0 ? walkPlayerMove(&game, &move) : jumpPlayerMove(&game, &move);
+            if (moved)
+            {
+                checksum[pass] += cellIndex(m, move.currentCell) * 31 + move.movementPoints * move.mpMultiplyer;
+            }
+            checksum[pass] = checksum[pass] * 3 + moved;
+        }
+        elapsed[pass] = nowSeconds() - start;
+    }
+
+    printf("\nMove benchmark: %ld random moves of 1..%d steps\n", moves, MAX_MOVE_STEPS);
+    printf("  step by step      %8.2f ns/move\n", 1e9 * elapsed[0] / moves);
+    printf("  step table        %8.2f ns/move  (%.2fx)\n", 1e9 * elapsed[1] / moves, elapsed[1] > 0 ? elapsed[0] / elapsed[1] : 0.0);
+    printf("  results %s\n", checksum[0] == checksum[1] ? "match" : "DIFFER");
+
+    free(list);
+    freeGame(&game);
+}
+
+// ----------------------------------------REACHABILITY BENCHMARK---------------------------------------
+
+// time flag checks from random cells with the BFS against the flood fill, and check both agree
+void runReachBenchmark(const Maze *m, unsigned int seed, long queries)
+{
+    Game game;
+    initGame(&game, m, seed, 0);
+
+    CellCord *starts = (CellCord *)malloc(queries * sizeof(CellCord));
+    bool *answers = (bool *)malloc(queries * sizeof(bool));
+    if (!starts || !answers)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (long i = 0; i < queries; i++)
+    {
+        do
+        {
+            starts[i] = cellFromIndex(m, (int)rngBelow(&game.rng, m->noCells));
+        } while (isBlockedCell(m, starts[i]));
+    }
+    changeStairDirection(&game);
+
+    long reachable = 0, differ = 0;
+    double start = nowSeconds();
+    for (long i = 0; i < queries; i++)
+    {
+        answers[i] = bfsFlagReachable(&game, starts[i]);
+    }
+    double bfsTime = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (long i = 0; i < queries; i++)
+    {
+        bool found = isFlagReachable(&game, starts[i]);
+        reachable += found;
+        differ += found != answers[i];
+    }
+    double floodTime = nowSeconds() - start;
+
+    DistanceField field;
+    initDistanceField(&field, m);
+    start = nowSeconds();
+    buildDistanceField(&game, &field);
+    double fieldBuildTime = nowSeconds() - start;
+
+    start = nowSeconds();
+    for (long i = 0; i < queries; i++)
+    {
+        differ += isFlagReachableFrom(&field, starts[i]) != answers[i];
+    }
+    double fieldTime = nowSeconds() - start;
+    freeDistanceField(&field);
+
+    printf("\nReachability benchmark: %ld queries on a %dx%dx%d maze\n", queries, m->floors, m->width, m->length);
+    printf("  BFS               %10.2f us/query\n", 1e6 * bfsTime / queries);
+    printf("  flood fill        %10.2f us/query  (%.2fx)\n", 1e6 * floodTime / queries, floodTime > 0 ? bfsTime / floodTime : 0.0);
+    printf("  distance field    %10.2f us to build, %.2f ns/query\n", 1e6 * fieldBuildTime, 1e9 * fieldTime / queries);
+    printf("  flag reachable from %ld of %ld cells, answers %s\n", reachable, queries, differ ? "DIFFER" : "match");
+
+    free(starts);
+    free(answers);
+    freeGame(&game);
+}
+
+// ----------------------------------------STAIR FLIP BENCHMARK---------------------------------------
+
+// time keeping flag reachability current across stair flips, tracker against a full distance field per flip
+void runFlipBenchmark(const Maze *m, unsigned int seed, long flips)
+{
+    Game game;
+    DistanceField field;
+    initGame(&game, m, seed, 0);
+    initDistanceField(&field, m);
+
+    // a player sits out its poison in Bawana and the others wait on its entry, so the round is cut off
+    // exactly when the entry is
+    if (m->no_BawanaCells)
+    {
+        for (int p = 0; p < game.players.count; p++)
+        {
+            setPlayerCell(&game, p, p ? BawanaEntry : m->bawanaCells[0].cellCoord);
+        }
+        game.players.status[0] = POISONED;
+        game.players.throwsLeftInStatus[0] = 3;
+    }
+
+    double trackerTime = 0, fieldTime = 0;
+    long differ = 0, cutOffFlips = 0, bawanaCutOff = 0;
+    for (long i = 0; i < flips; i++)
+    {
+        changeStairDirection(&game);
+
+        double start = nowSeconds();
+        updateFlagTracker(&game);
+        trackerTime += nowSeconds() - start;
+
+        start = nowSeconds();
+        buildDistanceField(&game, &field);
+        fieldTime += nowSeconds() - start;
+
+        bool cutOff = false;
+        for (int c = 0; c < m->noCells; c++)
+        {
+            CellCord cell = cellFromIndex(m, c);
+            if (!isBlockedCell(m, cell))
+            {
+                differ += canReachFlag(&game, cell) != isFlagReachableFrom(&field, cell);
+                cutOff = cutOff || !canReachFlag(&game, cell);
+            }
+        }
+        cutOffFlips += cutOff;
+
+        if (m->no_BawanaCells)
+        {
+            trackUnwinnableRound(&game);
+            bawanaCutOff += game.tracker.cutOff;
+            differ += game.tracker.cutOff != !canReachFlag(&game, BawanaEntry);
+        }
+    }
+
+    printf("\nStair flip benchmark: %ld flips, %d stairs, %d walking regions\n", flips, m->no_Stairs, m->no_Regions);
+    printf("  full distance field  %10.2f us/flip\n", 1e6 * fieldTime / flips);
+    printf("  flag tracker         %10.2f us/flip  (%.2fx), region graph searched on %ld flips\n",
+           1e6 * trackerTime / flips, trackerTime > 0 ? fieldTime / trackerTime : 0.0, game.tracker.searches - 1);
+    printf("  flips leaving some cell cut off from the flag: %ld, a poisoned player in Bawana on %ld, answers %s\n",
+           cutOffFlips, bawanaCutOff, differ ? "DIFFER" : "match");
+
+    freeDistanceField(&field);
+    freeGame(&game);
+}
+
+// ----------------------------------------MAZE SIZE BENCHMARK---------------------------------------
+
+// floors, width and length of the mazes the size benchmark builds, all with the default floor areas
+const int benchMazeSizes[][3] = {{3, 10, 25}, {3, 100, 250}, {6, 250, 500}, {12, 500, 1000}, {24, 1000, 1000}};
+
+// time building mazes of growing size, validating random objects on them and playing turns on them
+void runSizeBenchmark(unsigned int seed, long turns)
+{
+    const long checks = 100000;
+
+    printf("\nMaze size benchmark: %ld turns and %ld stair and wall checks per maze\n", turns, checks);
+    printf("  mazes over %d cells have no step table and walk every move\n", STEP_TABLE_MAX_CELLS);
+    printf("  floors x width x length       cells   arena(KB)   setup(ms)   table(ms)  check(ns)  turn(ns)\n");
+    for (int s = 0; s < (int)(sizeof(benchMazeSizes) / sizeof(benchMazeSizes[0])); s++)
+    {
+        Maze m = {0};
+        m.floors = benchMazeSizes[s][0];
+        m.width = benchMazeSizes[s][1];
+        m.length = benchMazeSizes[s][2];
+        defaultFloorAreas(&m);
+
+        double start = nowSeconds();
+        buildMaze(&m, seed);
+        double setupTime = nowSeconds() - start;
+        start = nowSeconds();
+        buildStepTable(&m);
+        double tableTime = nowSeconds() - start;
+
+        // random stairs and walls of up to 10 cells anywhere in the maze
+        Rng rng;
+        rngInit(&rng, seed, (uint64_t)s);
+        long valid = 0;
+        start = nowSeconds();
+        for (long i = 0; i < checks; i++)
+        {
+            int f = (int)rngBelow(&rng, m.floors), w = (int)rngBelow(&rng, m.width), l = (int)rngBelow(&rng, m.length);
+            int size = (int)rngBelow(&rng, 10);
+            struct Stair stair = {0, f, w, l, f + 1, (w + size) % m.width, (l + size) % m.length};
+            struct Wall wall = i % 2 ? (struct Wall){f, w, l, w, l + size} : (struct Wall){f, w, l, w + size, l};
+            valid += isValidStair(&m, stair, 0, false) + isValidWall(&m, wall, 0, false);
+        }
+        double checkTime = nowSeconds() - start;
+
+        // rounds as playGame plays them, a new game starts whenever one is won
+        Game game;
+        initGame(&game, &m, seed, 0);
+        long played = 0;
+        start = nowSeconds();
+        while (played < turns)
+        {
+            trackUnwinnableRound(&game);
+            for (int p = 0; p < game.players.count && game.winner == NO_WINNER; p++, played++)
+            {
+                playerTurn(&game, p);
+            }
+            if (game.winner != NO_WINNER)
+            {
+                resetGame(&game);
+                continue;
+            }
+            if (++game.gameRound % 5 == 0)
+            {
+                changeStairDirection(&game);
+                updateFlagTracker(&game);
+            }
+        }
+        double turnTime = nowSeconds() - start;
+
+        printf("  %6d x %5d x %6d  %11d  %10.0f  %10.1f  ", m.floors, m.width, m.length, m.noCells, m.arena.size / 1024.0, 1e3 * setupTime);
+        printf(m.stepTable ? "%10.1f" : "   too big", 1e3 * tableTime);
+        printf("  %9.1f  %8.1f\n", 1e9 * checkTime / (2 * checks), 1e9 * turnTime / played);
+        (void)valid;
+
+        freeGame(&game);
+        freeMaze(&m);
+    }
+}
+
+// ----------------------------------------PLAYER COUNT BENCHMARK---------------------------------------
+
+// time rounds of games with more and more players on the same maze, a new game starts whenever one is won
+void runPlayerBenchmark(const Maze *m, unsigned int seed, long rounds)
+{
+    const int counts[] = {3, 10, 100, 1000, 10000};
+
+    printf("\nPlayer count benchmark: %ld rounds per player count\n", rounds);
+    printf("    players      rounds  games won  round(us)  turn(ns)\n");
+    for (int c = 0; c < (int)(sizeof(counts) / sizeof(counts[0])); c++)
+    {
+        Maze crowd = *m; // the same maze with its own start cells
+        crowd.startCells = NULL;
+        crowd.startDirs = NULL;
+        placePlayers(&crowd, counts[c], seed);
+
+        Game game;
+        initGame(&game, &crowd, seed, 0);
+        long played = 0, won = 0;
+        double start = nowSeconds();
+        for (long r = 0; r < rounds; r++)
+        {
+            trackUnwinnableRound(&game);
+            for (int p = 0; p < game.players.count && game.winner == NO_WINNER; p++, played++)
+            {
+                playerTurn(&game, p);
+            }
+            if (game.winner != NO_WINNER)
+            {
+                resetGame(&game);
+                won++;
+                continue;
+            }
+            if (++game.gameRound % 5 == 0)
+            {
+                changeStairDirection(&game);
+                updateFlagTracker(&game);
+            }
+        }
+        double elapsed = nowSeconds() - start;
+        printf("  %9d  %10ld  %9ld  %9.2f  %8.1f\n", counts[c], rounds, won, 1e6 * elapsed / rounds, 1e9 * elapsed / played);
+
+        freeGame(&game);
+        free(crowd.startCells);
+        free(crowd.startDirs);
+    }
+}
+
+// ----------------------------------------LOAD BENCHMARK---------------------------------------
+
+// time loading stair files of growing size with the mapped loader against the two pass fscanf one
+void runLoadBenchmark(const Maze *m, unsigned int seed, long stairs)
+{
+    const char *path = "bench_stairs.txt";
+    Rng rng;
+    rngInit(&rng, seed, 0);
+
+    printf("\nLoad benchmark: stair files of up to %ld valid stairs\n", stairs);
+    printf("      stairs   size(KB)   fscanf(ms)   mapped(ms)   speedup   MB/s mapped\n");
+    for (long size = stairs / 100 > 0 ? stairs / 100 : stairs; size <= stairs; size *= 10)
+    {
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            printf("\nError: Could not write %s\n", path);
+            exit(1);
+        }
+        for (long i = 0; i < size;)
+        {
+            int f = (int)rngBelow(&rng, m->floors - 1);
+            struct Stair s = {0, f, (int)rngBelow(&rng, m->width), (int)rngBelow(&rng, m->length),
+                              f + 1, (int)rngBelow(&rng, m->width), (int)rngBelow(&rng, m->length)};
+            if (isValidStair(m, s, 0, false))
+            {
+                fprintf(file, "[%d, %d, %d, %d, %d, %d]\n", s.startFloor, s.startBlockWidth, s.startBlockLength,
+                        s.endFloor, s.endBlockWidth, s.endBlockLength);
+                i++;
+            }
+        }
+        long bytes = ftell(file);
+        fclose(file);
+
+        Maze scanned = *m, mapped = *m; // only the stairs are replaced
+        double start = nowSeconds();
+        loadStairsScanf(&scanned, path);
+        double scanfTime = nowSeconds() - start;
+        start = nowSeconds();
+        loadStairsFile(&mapped, path);
+        double mappedTime = nowSeconds() - start;
+
+        bool same = scanned.no_Stairs == mapped.no_Stairs &&
+                    memcmp(scanned.stairs, mapped.stairs, mapped.no_Stairs * sizeof(struct Stair)) == 0;
+        printf("  %10ld  %9.0f  %11.2f  %11.2f  %8.2fx  %12.0f  %s\n", size, bytes / 1024.0, 1e3 * scanfTime, 1e3 * mappedTime,
+               mappedTime > 0 ? scanfTime / mappedTime : 0.0, mappedTime > 0 ? bytes / 1048576.0 / mappedTime : 0.0,
+               same ? "" : "stairs DIFFER");
+        free(scanned.stairs);
+        free(mapped.stairs);
+        if (size == stairs)
+        {
+            break;
+        }
+    }
+    remove(path);
+}
+
+// ----------------------------------------WHAT IF---------------------------------------
+
+// play game gameIndex up to round, or take its position from a saved game, then play it on along many branches
+void runWhatIf(const Maze *m, unsigned int seed, long gameIndex, int round, long branches, const char *loadPath, const char *savePath)
+{
+    Game base, branch;
+    initGame(&base, m, seed, gameIndex);
+    initGame(&branch, m, seed, gameIndex);
+
+    double start = nowSeconds();
+    if (loadPath)
+    {
+        loadGameFile(&base, loadPath);
+    }
+    else
+    {
+        continueGame(&base, round);
+    }
+    double prefixTime = nowSeconds() - start;
+    if (savePath)
+    {
+        saveGameFile(&base, savePath);
+    }
+
+    // the saved state must play on exactly like the game it was taken from
+    void *saved = malloc(gameStateSize(&base));
+    if (!saved)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    saveGameState(&base, saved);
+    restoreGameState(&branch, saved, gameStateSize(&base));
+    GameResult restored = continueGame(&branch, MAX_ROUNDS);
+    forkGame(&branch, &base, 0);
+    GameResult forked = continueGame(&branch, MAX_ROUNDS);
+    bool same = restored.winner == forked.winner && restored.rounds == forked.rounds;
+    free(saved);
+
+    if (loadPath)
+    {
+        printf("\nWhat if: %s from round %d, %zu byte state\n", loadPath, base.gameRound, gameStateSize(&base));
+    }
+    else
+    {
+        printf("\nWhat if: game %ld from round %d, %zu byte state\n", gameIndex, base.gameRound, gameStateSize(&base));
+    }
+    char name[NAME_STR_SIZE];
+    if (base.winner != NO_WINNER)
+    {
+        printf("  already won by %s\n", playerName(base.winner, name));
+    }
+    else if (forked.winner != NO_WINNER)
+    {
+        printf("  as played: %s wins in round %d%s\n", playerName(forked.winner, name), forked.rounds, same ? "" : ", the restored state played on DIFFERENTLY");
+    }
+    else
+    {
+        printf("  as played: unfinished after %d rounds%s\n", forked.rounds, same ? "" : ", the restored state played on DIFFERENTLY");
+    }
+
+    BatchStats stats = {0};
+    double forkTime = 0;
+    start = nowSeconds();
+    for (long b = 1; b <= branches; b++)
+    {
+        double forkStart = nowSeconds();
+        forkGame(&branch, &base, (uint64_t)b);
+        forkTime += nowSeconds() - forkStart;
+        addGameResult(&stats, &branch, continueGame(&branch, MAX_ROUNDS));
+    }
+    printBatchStats(&stats, nowSeconds() - start);
+    printf("  fork: %.0f ns, replaying the %d rounds before it: %.1f us\n", branches ? 1e9 * forkTime / branches : 0.0,
+           base.gameRound, 1e6 * prefixTime);
+
+    freeGame(&base);
+    freeGame(&branch);
+}
+
+// ----------------------------------------STARTUP BENCHMARK---------------------------------------
+
+// time getting a playable maze from the text files against mapping a snapshot of it
+void runStartupBenchmark(unsigned int seed, long runs)
+{
+    const char *path = "bench_maze.snl";
+    long textRuns = runs < 10 ? runs : 10; // every text build logs its invalid lines again, a few are enough
+
+    double start = nowSeconds();
+    for (long i = 0; i < textRuns; i++)
+    {
+        Maze m;
+        intializeMaze(&m, seed);
+        buildStepTable(&m);
+        if (i == 0)
+        {
+            saveMazeSnapshot(&m, seed, path);
+        }
+        freeMaze(&m);
+    }
+    double textTime = (nowSeconds() - start) / textRuns;
+
+    start = nowSeconds();
+    long checksum = 0;
+    for (long i = 0; i < runs; i++)
+    {
+        Maze m;
+        checksum += loadMazeSnapshot(&m, path) + m.cells[cellIndex(&m, m.Flag)];
+        freeMaze(&m);
+    }
+    double snapshotTime = (nowSeconds() - start) / runs;
+
+    printf("\nStartup benchmark: %ld runs\n", runs);
+    printf("  text files  %10.1f us\n", 1e6 * textTime);
+    printf("  snapshot    %10.1f us   %.0fx faster\n", 1e6 * snapshotTime, snapshotTime > 0 ? textTime / snapshotTime : 0.0);
+    (void)checksum;
+    remove(path);
+}
+
+#endif
@@ -0,0 +1,325 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "maze.h"
+#include "play.h"
+
+// ----------------------------------------MAZE SNAPSHOT---------------------------------------
+// a fully built maze written as one binary file: a header, then every array of the maze as it is in memory, each
+// on its own cache line. loading maps the file read only and points the maze into it, so there is nothing to
+// parse or shuffle and every process loading the same snapshot shares its pages.
+
+#define SNAPSHOT_MAGIC "SNLMAZE"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ENDIAN 0x01020304u // reads back differently on a machine of the other byte order
+
+typedef enum
+{
+    SNAP_CELLS,
+    SNAP_WALKABLE,
+    SNAP_REGION,
+    SNAP_STAIRS,
+    SNAP_POLES,
+    SNAP_WALLS,
+    SNAP_BAWANA_CELLS,
+    SNAP_STAIR_LINKS,
+    SNAP_POLE_EDGES,
+    SNAP_AREAS,
+    SNAP_STEP_TABLE,
+    SNAP_SECTIONS
+} SnapshotSection;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endian;
+    uint32_t layout[SNAP_SECTIONS]; // element size of every section, a build with other struct layouts can not read it
+    uint32_t seed;                  // seed the movement points and Bawana were shuffled with
+    int32_t floors;
+    int32_t width;
+    int32_t length;
+    CellCord flag;
+    int32_t no_Stairs;
+    int32_t no_Poles;
+    int32_t no_Walls;
+    int32_t no_BawanaCells;
+    int32_t no_Regions;
+    int32_t no_PoleEdges;
+    int32_t no_Areas;
+    uint64_t offset[SNAP_SECTIONS]; // from the start of the file
+    uint64_t bytes[SNAP_SECTIONS];  // 0 for a missing step table
+} SnapshotHeader;
+
+// element size of every section in this build
+void snapshotLayout(uint32_t layout[SNAP_SECTIONS])
+{
+    layout[SNAP_CELLS] = sizeof(Cell);
+    layout[SNAP_WALKABLE] = sizeof(uint64_t);
+    layout[SNAP_REGION] = sizeof(int);
+    layout[SNAP_STAIRS] = sizeof(struct Stair);
+    layout[SNAP_POLES] = sizeof(struct Pole);
+    layout[SNAP_WALLS] = sizeof(struct Wall);
+    layout[SNAP_BAWANA_CELLS] = sizeof(struct BawanaCell);
+    layout[SNAP_STAIR_LINKS] = sizeof(struct StairLink);
+    layout[SNAP_POLE_EDGES] = sizeof(struct RegionEdge);
+    layout[SNAP_AREAS] = sizeof(struct FloorArea);
+    layout[SNAP_STEP_TABLE] = sizeof(struct StepEntry);
+}
+
+// number of elements every section of the maze has, the step table is counted only if the maze has one
+void snapshotCounts(const Maze *m, bool hasStepTable, uint64_t counts[SNAP_SECTIONS])
+{
+    counts[SNAP_CELLS] = m->noCells;
+    counts[SNAP_WALKABLE] = rowOffset(m, m->floors, 0);
+    counts[SNAP_REGION] = m->noCells;
+    counts[SNAP_STAIRS] = m->no_Stairs;
+    counts[SNAP_POLES] = m->no_Poles;
+    counts[SNAP_WALLS] = m->no_Walls;
+    counts[SNAP_BAWANA_CELLS] = m->no_BawanaCells;
+    counts[SNAP_STAIR_LINKS] = m->no_Stairs;
+    counts[SNAP_POLE_EDGES] = m->no_PoleEdges;
+    counts[SNAP_AREAS] = m->no_Areas;
+    counts[SNAP_STEP_TABLE] = hasStepTable ? (uint64_t)m->noCells * 4 * MAX_MOVE_STEPS : 0;
+}
+
+// write a built maze and the seed it was built with
+void saveMazeSnapshot(const Maze *m, unsigned int seed, const char *path)
+{
+    const void *data[SNAP_SECTIONS] = {m->cells, m->walkable, m->region, m->stairs, m->poles, m->walls,
+                                       m->bawanaCells, m->stairLinks, m->poleEdges, m->areas, m->stepTable};
+    SnapshotHeader header = {.magic = SNAPSHOT_MAGIC, .version = SNAPSHOT_VERSION, .endian = SNAPSHOT_ENDIAN};
+    uint64_t counts[SNAP_SECTIONS];
+    snapshotLayout(header.layout);
+    snapshotCounts(m, m->stepTable != NULL, counts);
+    header.seed = seed;
+    header.floors = m->floors;
+    header.width = m->width;
+    header.length = m->length;
+    header.flag = m->Flag;
+    header.no_Stairs = m->no_Stairs;
+    header.no_Poles = m->no_Poles;
+    header.no_Walls = m->no_Walls;
+    header.no_BawanaCells = m->no_BawanaCells;
+    header.no_Regions = m->no_Regions;
+    header.no_PoleEdges = m->no_PoleEdges;
+    header.no_Areas = m->no_Areas;
+
+    uint64_t offset = arenaBlockSize(sizeof(header));
+    for (int s = 0; s < SNAP_SECTIONS; s++)
+    {
+        header.bytes[s] = counts[s] * header.layout[s];
+        header.offset[s] = offset;
+        offset += arenaBlockSize(header.bytes[s]);
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+    {
+        printf("\nError: Could not write %s\n", path);
+        exit(1);
+    }
+    static const char padding[64];
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t at = sizeof(header);
+    for (int s = 0; s < SNAP_SECTIONS && written; s++)
+    {
+        written = fwrite(padding, 1, header.offset[s] - at, file) == header.offset[s] - at &&
+                  fwrite(data[s], 1, header.bytes[s], file) == header.bytes[s];
+        at = header.offset[s] + header.bytes[s];
+    }
+    if (fclose(file) != 0 || !written)
+    {
+        printf("\nError: Could not write %s\n", path);
+        exit(1);
+    }
+}
+
+// every id and cell a section holds must be inside the maze, a damaged snapshot would otherwise index past its
+// arrays. the reason it is not, or NULL
+const char *snapshotContentError(const Maze *m)
+{
+    if (!isValidCordinates(m, m->Flag) || m->no_Regions > m->noCells)
+    {
+        return "flag or region count out of range";
+    }
+    for (int c = 0; c < m->noCells; c++)
+    {
+        CellType type = cellTypeOf(m->cells[c]);
+        int id = cellIdOf(m->cells[c]);
+        if (type > BAWANA_ENTRY || (type == STAIR_CELL && (id < 0 || id >= m->no_Stairs)) ||
+            (type == POLE_CELL && (id < 0 || id >= m->no_Poles)) ||
+            (type == BAWANA_CELL && (id < 0 || id >= m->no_BawanaCells)) ||
+            m->region[c] < -1 || m->region[c] >= m->no_Regions)
+        {
+            return "cell with an unknown type, object or region";
+        }
+    }
+    if (m->region[cellIndex(m, m->Flag)] == -1)
+    {
+        return "flag outside every walking region";
+    }
+
+    for (int i = 0; i < m->no_Stairs; i++)
+    {
+        struct Stair s = m->stairs[i];
+        struct StairLink link = m->stairLinks[i];
+        if (!isValidCordinates(m, (CellCord){s.startFloor, s.startBlockWidth, s.startBlockLength}) ||
+            !isValidCordinates(m, (CellCord){s.endFloor, s.endBlockWidth, s.endBlockLength}) ||
+            link.startRegion < 0 || link.startRegion >= m->no_Regions || link.endRegion < 0 || link.endRegion >= m->no_Regions)
+        {
+            return "stair out of range";
+        }
+    }
+    for (int i = 0; i < m->no_Poles; i++)
+    {
+        struct Pole p = m->poles[i];
+        if (!isValidFloor(m, p.startFloor) || !isValidFloor(m, p.endFloor) || p.startFloor > p.endFloor ||
+            !isValidWidth(m, p.widthCell) || !isValidLength(m, p.lengthCell))
+        {
+            return "pole out of range";
+        }
+    }
+    for (int i = 0; i < m->no_Walls; i++)
+    {
+        struct Wall w = m->walls[i];
+        if (!isValidCordinates(m, (CellCord){w.floor, w.startBlockWidth, w.startBlockLength}) ||
+            !isValidCordinates(m, (CellCord){w.floor, w.endBlockWidth, w.endBlockLength}))
+        {
+            return "wall out of range";
+        }
+    }
+    for (int i = 0; i < m->no_BawanaCells; i++)
+    {
+        if (!isValidCordinates(m, m->bawanaCells[i].cellCoord) || m->bawanaCells[i].type > RANDOM_CELL)
+        {
+            return "Bawana cell out of range";
+        }
+    }
+    for (int i = 0; i < m->no_PoleEdges; i++)
+    {
+        struct RegionEdge e = m->poleEdges[i];
+        if (e.from < 0 || e.from >= m->no_Regions || e.to < 0 || e.to >= m->no_Regions)
+        {
+            return "pole ride out of range";
+        }
+    }
+    for (int i = 0; i < m->no_Areas; i++)
+    {
+        if (!isValidFloorArea(m, m->areas[i], i + 1, false))
+        {
+            return "floor area out of range";
+        }
+    }
+    if (m->stepTable)
+    {
+        for (long i = 0; i < (long)m->noCells * 4 * MAX_MOVE_STEPS; i++)
+        {
+            struct StepEntry e = m->stepTable[i];
+            if (e.dest < 0 || e.dest >= m->noCells || e.stop < STEP_DONE || e.stop > STEP_FLAG || e.steps < 0 ||
+                e.steps > MAX_MOVE_STEPS || (e.steps == 0 && e.stop != STEP_BLOCKED) ||
+                (e.stop == STEP_STAIR && cellTypeOf(m->cells[e.dest]) != STAIR_CELL))
+            {
+                return "step table out of range";
+            }
+        }
+    }
+    return NULL;
+}
+
+void snapshotError(MappedFile *file, const char *path, const char *reason)
+{
+    printf("\nError: %s is not a usable maze snapshot: %s.\n", path, reason);
+    unmapFile(file);
+    exit(1);
+}
+
+// point the maze into a mapped snapshot, returns the seed it was built with. the maze must not be written to
+unsigned int loadMazeSnapshot(Maze *m, const char *path)
+{
+    MappedFile file;
+    if (!mapFile(&file, path))
+    {
+        printf("\nError: Could not open %s\n", path);
+        exit(1);
+    }
+    const SnapshotHeader *header = (const SnapshotHeader *)file.data;
+    if (file.size < sizeof(SnapshotHeader) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+    {
+        snapshotError(&file, path, "no snapshot header");
+    }
+    if (header->version != SNAPSHOT_VERSION)
+    {
+        snapshotError(&file, path, "written by another version");
+    }
+    uint32_t layout[SNAP_SECTIONS];
+    snapshotLayout(layout);
+    if (header->endian != SNAPSHOT_ENDIAN || memcmp(header->layout, layout, sizeof(layout)) != 0)
+    {
+        snapshotError(&file, path, "written by a build with another byte order or struct layout");
+    }
+
+    // sizes as loadMazeSize accepts them, everything below indexes with them
+    if (header->floors < 1 || header->width < MIN_WIDTH || header->length < MIN_LENGTH ||
+        (long long)header->floors * header->width * header->length > 0x7FFFFFFF || header->no_Stairs < 0 ||
+        header->no_Poles < 0 || header->no_Walls < 0 || header->no_BawanaCells < 0 || header->no_Regions < 0 ||
+        header->no_PoleEdges < 0 || header->no_Areas < 0)
+    {
+        snapshotError(&file, path, "maze size or object counts out of range");
+    }
+
+    *m = (Maze){0};
+    m->floors = header->floors;
+    m->width = header->width;
+    m->length = header->length;
+    m->rowWords = (m->length + 63) / 64;
+    m->noCells = m->floors * m->width * m->length;
+    m->Flag = header->flag;
+    m->no_Stairs = header->no_Stairs;
+    m->no_Poles = header->no_Poles;
+    m->no_Walls = header->no_Walls;
+    m->no_BawanaCells = header->no_BawanaCells;
+    m->no_Regions = header->no_Regions;
+    m->no_PoleEdges = header->no_PoleEdges;
+    m->no_Areas = header->no_Areas;
+
+    // every section must hold exactly what the counts say and lie inside the file
+    uint64_t counts[SNAP_SECTIONS];
+    snapshotCounts(m, true, counts);
+    for (int s = 0; s < SNAP_SECTIONS; s++)
+    {
+        bool missingTable = s == SNAP_STEP_TABLE && header->bytes[s] == 0;
+        if ((header->bytes[s] != counts[s] * layout[s] && !missingTable) || header->offset[s] % 64 != 0 ||
+            header->offset[s] > file.size || header->bytes[s] > file.size - header->offset[s])
+        {
+            snapshotError(&file, path, "sections do not match the header");
+        }
+    }
+
+    const char *base = file.data;
+    m->cells = (Cell *)(base + header->offset[SNAP_CELLS]);
+    m->walkable = (uint64_t *)(base + header->offset[SNAP_WALKABLE]);
+    m->region = (int *)(base + header->offset[SNAP_REGION]);
+    m->stairs = (struct Stair *)(base + header->offset[SNAP_STAIRS]);
+    m->poles = (struct Pole *)(base + header->offset[SNAP_POLES]);
+    m->walls = (struct Wall *)(base + header->offset[SNAP_WALLS]);
+    m->bawanaCells = (struct BawanaCell *)(base + header->offset[SNAP_BAWANA_CELLS]);
+    m->stairLinks = (struct StairLink *)(base + header->offset[SNAP_STAIR_LINKS]);
+    m->poleEdges = (struct RegionEdge *)(base + header->offset[SNAP_POLE_EDGES]);
+    m->areas = (struct FloorArea *)(base + header->offset[SNAP_AREAS]);
+    m->stepTable = header->bytes[SNAP_STEP_TABLE] ? (struct StepEntry *)(base + header->offset[SNAP_STEP_TABLE]) : NULL;
+    if (m->stepTable && m->noCells > STEP_TABLE_MAX_CELLS)
+    {
+        snapshotError(&file, path, "step table of a maze too big to have one");
+    }
+    const char *reason = snapshotContentError(m);
+    if (reason)
+    {
+        snapshotError(&file, path, reason);
+    }
+    m->snapshot = file;
+    placePlayers(m, DEFAULT_PLAYERS, header->seed);
+    return header->seed;
+}
+
+#endif
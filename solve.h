@@ -0,0 +1,939 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include "sim.h"
+
+// ----------------------------------------SOLO CHAINS---------------------------------------
+// a player is a Markov chain over (cell, direction, status, throws left in the status, throw count mod 4) - the
+// base of a state - and movement points. the points are kept at a set of levels, a turn that ends between two
+// levels goes to both, weighted so the expected points stay the same. every outcome of a turn is found by playing
+// the real turn with dice from a script, once per base with points no turn can use up. the script also rolls the
+// direction of each stair the turn takes, so the stairs count with the chances their flips give them, drawn again
+// every turn where the game keeps a direction for 5 rounds and starts every stair both ways. the points only decide whether a move runs the player dry, so
+// the chain keeps the outcomes of each base and shifts the points of every level by them as it is followed, the
+// moves that end at 0 or below going to a Bawana cell. the other players come in through captures, see
+// followChains
+
+#define MP_LEVELS 59
+const int mpLevels[MP_LEVELS] = {-64, -48, -32, -24, -16, -12, -8, -6, -4, -2, 0, 2, 4, 6, 8, 10, 12, 14, 16, 18,
+                                 20, 22, 24, 26, 28, 30, 32, 36, 40, 44, 48, 52, 56, 60, 64, 72, 80, 88, 96, 104,
+                                 112, 120, 128, 144, 160, 176, 192, 208, 224, 240, 256, 288, 320, 352, 384, 416, 448,
+                                 480, 512};
+#define MP_SPAN (512 + 64 + 1) // points from the lowest level to the highest
+
+int mpLevelBelow[MP_SPAN];     // [mp + 64] the highest level at or below mp
+double mpUpperWeight[MP_SPAN]; // [mp + 64] the share of mp that goes to the level above it
+
+#define SOLVE_POINTS (1 << 24) // movement points of the turns that find a base's outcomes
+
+typedef enum
+{
+    OUTCOME_WIN,
+    OUTCOME_SHIFT, // the points change by value
+    OUTCOME_MOVE,  // as OUTCOME_SHIFT, but a move that sends the player to Bawana if it leaves them at 0 or below
+    OUTCOME_SET    // the points become value, the turn ended at a Bawana cell
+} OutcomeKind;
+
+typedef struct
+{
+    double prob;
+    int base;
+    int value;
+    int landed; // cell the turn captured anyone on, -1 if it did not look
+    char kind;
+    char dry; // for OUTCOME_MOVE the Bawana table the player goes by, facing * 4 + throw count mod 4
+} TurnOutcome;
+
+typedef struct
+{
+    int base;
+    int mp;
+    bool entry; // the player comes out on BawanaEntry and captures anyone there
+} BawanaOutcome;
+
+typedef struct
+{
+    uint64_t *baseKeys; // [base] packed base
+    int *firstOutcome;  // [base] -1 until the base's outcomes are worked out, the wins are left out of them
+    int *no_Outcomes;
+    double *winProb; // [base] chance a turn from the base captures the flag
+    int *captured;   // [base] the same base on the player's start cell, where a capture sends it
+    int *landStart;  // [base + 1] the cells a turn from the base captures on and the chances of each
+    int no_Bases;
+    long baseCapacity;
+    uint64_t *slotKeys; // open addressing from a base key + 1 to its base, 0 marks a free slot
+    int *slotBases;
+    size_t slots;
+
+    TurnOutcome *outcomes;
+    long no_TurnOutcomes;
+    long outcomeCapacity;
+    BawanaOutcome *bawana; // [facing * 4 + throw count mod 4][Bawana cell] where running dry leaves the player
+    int no_Bawana;
+    int *landCells;
+    double *landProbs;
+    long no_Landings;
+    long landCapacity;
+
+    int *baseCell;   // [base] filled in once the chain is built
+    int *classBases; // the bases by throw count mod 4, class k from classStart[k] to classStart[k + 1]
+    int classStart[5];
+} SoloChain;
+
+typedef struct
+{
+    int cell, throwsLeft, throwMod;
+    Direction dir;
+    PlayerStatus status;
+} SoloBase;
+
+uint64_t packSoloBase(SoloBase b) { return (((uint64_t)b.cell * 4 + b.dir) * 8 + b.status) * 32 + b.throwsLeft * 4 + b.throwMod; }
+
+SoloBase unpackSoloBase(uint64_t key)
+{
+    SoloBase b;
+    b.throwMod = key % 4;
+    b.throwsLeft = (key / 4) % 8;
+    key /= 32;
+    b.status = (PlayerStatus)(key % 8);
+    key /= 8;
+    b.dir = (Direction)(key % 4);
+    b.cell = (int)(key / 4);
+    return b;
+}
+
+void *growArray(void *array, long count, size_t size)
+{
+    void *grown = realloc(array, count * size);
+    if (!grown)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    return grown;
+}
+
+size_t baseSlot(const SoloChain *c, uint64_t key)
+{
+    size_t slot = (size_t)((key + 1) * 0x9E3779B97F4A7C15ull >> 20) & (c->slots - 1);
+    while (c->slotKeys[slot] && c->slotKeys[slot] != key + 1)
+    {
+        slot = (slot + 1) & (c->slots - 1);
+    }
+    return slot;
+}
+
+// the base of the key, added to the chain if it is new
+int soloBaseId(SoloChain *c, uint64_t key)
+{
+    size_t slot = baseSlot(c, key);
+    if (c->slotKeys[slot])
+    {
+        return c->slotBases[slot];
+    }
+    if (c->no_Bases == c->baseCapacity)
+    {
+        c->baseCapacity *= 2;
+        c->baseKeys = (uint64_t *)growArray(c->baseKeys, c->baseCapacity, sizeof(uint64_t));
+        c->firstOutcome = (int *)growArray(c->firstOutcome, c->baseCapacity, sizeof(int));
+        c->no_Outcomes = (int *)growArray(c->no_Outcomes, c->baseCapacity, sizeof(int));
+        c->winProb = (double *)growArray(c->winProb, c->baseCapacity, sizeof(double));
+        c->captured = (int *)growArray(c->captured, c->baseCapacity, sizeof(int));
+        c->landStart = (int *)growArray(c->landStart, c->baseCapacity + 1, sizeof(int));
+    }
+    int base = c->no_Bases++;
+    c->slotKeys[slot] = key + 1;
+    c->slotBases[slot] = base;
+    c->baseKeys[base] = key;
+    c->firstOutcome[base] = -1;
+    c->no_Outcomes[base] = 0;
+
+    if (2 * (size_t)c->no_Bases > c->slots)
+    { // half full, spread the keys over twice the slots
+        uint64_t *oldKeys = c->slotKeys;
+        int *oldBases = c->slotBases;
+        size_t oldSlots = c->slots;
+        c->slots *= 2;
+        c->slotKeys = (uint64_t *)calloc(c->slots, sizeof(uint64_t));
+        c->slotBases = (int *)growArray(NULL, c->slots, sizeof(int));
+        if (!c->slotKeys)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+        for (size_t i = 0; i < oldSlots; i++)
+        {
+            if (oldKeys[i])
+            {
+                size_t to = baseSlot(c, oldKeys[i] - 1);
+                c->slotKeys[to] = oldKeys[i];
+                c->slotBases[to] = oldBases[i];
+            }
+        }
+        free(oldKeys);
+        free(oldBases);
+    }
+    return base;
+}
+
+// the tables addPoints splits points by
+void fillPointLevels()
+{
+    for (int k = 0, points = mpLevels[0]; points <= mpLevels[MP_LEVELS - 1]; points++)
+    {
+        k += k + 1 < MP_LEVELS && mpLevels[k + 1] <= points;
+        mpLevelBelow[points - mpLevels[0]] = k;
+        mpUpperWeight[points - mpLevels[0]] = k + 1 < MP_LEVELS ? (double)(points - mpLevels[k]) / (mpLevels[k + 1] - mpLevels[k]) : 0;
+    }
+}
+
+SoloBase soloBaseOf(const Game *g, int p)
+{
+    const Players *ps = &g->players;
+    return (SoloBase){cellIndex(g->maze, ps->currentCell[p]), ps->throwsLeftInStatus[p], ps->throwsCount[p] % 4, ps->dir[p], ps->status[p]};
+}
+
+void putSoloBase(Game *g, int p, uint64_t key, int mp)
+{
+    Players *ps = &g->players;
+    SoloBase b = unpackSoloBase(key);
+    setPlayerCell(g, p, cellFromIndex(g->maze, b.cell));
+    ps->dir[p] = b.dir;
+    ps->status[p] = b.status;
+    ps->throwsLeftInStatus[p] = b.throwsLeft;
+    ps->throwsCount[p] = b.throwMod;
+    ps->movementPoints[p] = mp;
+    g->winner = NO_WINNER;
+}
+
+// what a turn did that the player's fields do not tell: whether it got to the check for running dry and facing
+// which way, whether a Bawana cell set the points, and where it looked for players to capture
+typedef struct
+{
+    const Maze *maze;
+    bool moved;
+    bool bawana;
+    Direction facing;
+    int landed;
+} TurnWatch;
+
+void watchTurnEvent(void *context, const GameEvent *e)
+{
+    TurnWatch *w = (TurnWatch *)context;
+    if (e->kind == EVENT_MOVE)
+    {
+        w->moved = true;
+        w->facing = (Direction)e->facing;
+        w->landed = cellIndex(w->maze, e->to);
+    }
+    else if (e->kind == EVENT_BAWANA)
+    {
+        w->bawana = true;
+        w->landed = e->value == POISONED_CELL ? -1 : cellIndex(w->maze, BawanaEntry);
+    }
+}
+
+// every outcome of one turn from the base: the script starts with all rolls 0 and counts up like an odometer,
+// the rolls a turn did not make are not counted
+void findTurnOutcomes(SoloChain *c, Game *g, int p, int base)
+{
+    DiceScript script = {0};
+    TurnWatch watch;
+    EventSink sink = {watchTurnEvent, &watch};
+    script.rollStairs = true;
+    g->script = &script;
+    g->sink = &sink;
+    c->firstOutcome[base] = (int)c->no_TurnOutcomes;
+    c->no_Outcomes[base] = 0;
+    while (1)
+    {
+        putSoloBase(g, p, c->baseKeys[base], SOLVE_POINTS);
+        script.used = 0;
+        script.no_StairRolls = 0;
+        watch = (TurnWatch){g->maze, false, false, NORTH, -1};
+        playerTurn(g, p);
+
+        TurnOutcome o = {.prob = 1};
+        for (int i = 0; i < script.used; i++)
+        {
+            o.prob /= script.ranges[i];
+        }
+        if (g->winner == p)
+        {
+            o.kind = OUTCOME_WIN;
+        }
+        else
+        {
+            SoloBase after = soloBaseOf(g, p);
+            int mp = g->players.movementPoints[p];
+            o.base = soloBaseId(c, packSoloBase(after));
+            o.kind = watch.bawana ? OUTCOME_SET : watch.moved ? OUTCOME_MOVE : OUTCOME_SHIFT;
+            o.value = watch.bawana ? mp : mp - SOLVE_POINTS;
+            o.dry = (char)(watch.facing * 4 + after.throwMod);
+            o.landed = watch.landed;
+        }
+        if (c->no_TurnOutcomes == c->outcomeCapacity)
+        {
+            c->outcomeCapacity *= 2;
+            c->outcomes = (TurnOutcome *)growArray(c->outcomes, c->outcomeCapacity, sizeof(TurnOutcome));
+        }
+        c->outcomes[c->no_TurnOutcomes++] = o;
+        c->no_Outcomes[base]++;
+
+        for (int i = script.given; i < script.used; i++)
+        {
+            script.rolls[i] = 0;
+        }
+        script.given = script.used;
+        while (script.given > 0 && script.rolls[script.given - 1] + 1 == script.ranges[script.given - 1])
+        {
+            script.given--;
+        }
+        if (script.given == 0)
+        {
+            break;
+        }
+        script.rolls[script.given - 1]++;
+    }
+    g->script = NULL;
+    g->sink = NULL;
+}
+
+// where a player facing each way at each throw count mod 4 ends up from every Bawana cell after running dry
+void findBawanaOutcomes(SoloChain *c, Game *g, int p)
+{
+    const Maze *m = g->maze;
+    c->bawana = (BawanaOutcome *)growArray(NULL, 16 * m->no_BawanaCells, sizeof(BawanaOutcome));
+    for (int table = 0; table < 16; table++)
+    {
+        for (int k = 0; k < m->no_BawanaCells; k++)
+        {
+            SoloBase b = {cellIndex(m, BawanaEntry), 0, table % 4, (Direction)(table / 4), IN_MAZE};
+            putSoloBase(g, p, packSoloBase(b), 0);
+            struct BawanaCell bawana = m->bawanaCells[k];
+            applyBawanaEffect(g, p, &bawana);
+            backToStartingArea(g, p);
+            c->bawana[table * m->no_BawanaCells + k] = (BawanaOutcome){soloBaseId(c, packSoloBase(soloBaseOf(g, p))),
+                                                                       g->players.movementPoints[p], bawana.type != POISONED_CELL};
+        }
+    }
+}
+
+bool sameOutcome(TurnOutcome a, TurnOutcome b) { return a.kind == b.kind && a.base == b.base && a.value == b.value && (a.kind != OUTCOME_MOVE || a.dry == b.dry); }
+
+// the chance the base's turn captures on the cell
+void addLanding(SoloChain *c, int base, int cell, double prob)
+{
+    long at = c->landStart[base];
+    while (at < c->no_Landings && c->landCells[at] != cell)
+    {
+        at++;
+    }
+    if (at == c->no_Landings)
+    {
+        if (c->no_Landings == c->landCapacity)
+        {
+            c->landCapacity *= 2;
+            c->landCells = (int *)growArray(c->landCells, c->landCapacity, sizeof(int));
+            c->landProbs = (double *)growArray(c->landProbs, c->landCapacity, sizeof(double));
+        }
+        c->landCells[c->no_Landings] = cell;
+        c->landProbs[c->no_Landings++] = 0;
+    }
+    c->landProbs[at] += prob;
+}
+
+// the outcomes the base's turn was just found to have: the wins are summed into its chance of capturing the flag,
+// the cells it captures on listed, and the outcomes that end the same way summed
+void mergeTurnOutcomes(SoloChain *c, int base)
+{
+    int first = c->firstOutcome[base];
+    int kept = 0;
+    c->winProb[base] = 0;
+    c->landStart[base] = (int)c->no_Landings;
+    for (int i = 0; i < c->no_Outcomes[base]; i++)
+    {
+        TurnOutcome o = c->outcomes[first + i];
+        if (o.kind == OUTCOME_WIN)
+        {
+            c->winProb[base] += o.prob;
+            continue;
+        }
+        if (o.landed != -1)
+        {
+            addLanding(c, base, o.landed, o.prob);
+        }
+        int at = 0;
+        while (at < kept && !sameOutcome(c->outcomes[first + at], o))
+        {
+            at++;
+        }
+        if (at == kept)
+        {
+            c->outcomes[first + kept++] = o;
+        }
+        else
+        {
+            c->outcomes[first + at].prob += o.prob;
+        }
+    }
+    c->no_Outcomes[base] = kept;
+    c->no_TurnOutcomes = first + kept;
+    c->landStart[base + 1] = (int)c->no_Landings;
+}
+
+// every base the player can get to from where they are in the game, and the outcomes of a turn from each
+void buildSoloChain(SoloChain *c, const Game *from, int p)
+{
+    *c = (SoloChain){0};
+    fillPointLevels();
+    c->baseCapacity = 1 << 12;
+    c->outcomeCapacity = 1 << 16;
+    c->landCapacity = 1 << 16;
+    c->slots = 1 << 13;
+    c->baseKeys = (uint64_t *)growArray(NULL, c->baseCapacity, sizeof(uint64_t));
+    c->firstOutcome = (int *)growArray(NULL, c->baseCapacity, sizeof(int));
+    c->no_Outcomes = (int *)growArray(NULL, c->baseCapacity, sizeof(int));
+    c->winProb = (double *)growArray(NULL, c->baseCapacity, sizeof(double));
+    c->captured = (int *)growArray(NULL, c->baseCapacity, sizeof(int));
+    c->landStart = (int *)growArray(NULL, c->baseCapacity + 1, sizeof(int));
+    c->outcomes = (TurnOutcome *)growArray(NULL, c->outcomeCapacity, sizeof(TurnOutcome));
+    c->landCells = (int *)growArray(NULL, c->landCapacity, sizeof(int));
+    c->landProbs = (double *)growArray(NULL, c->landCapacity, sizeof(double));
+    c->slotKeys = (uint64_t *)calloc(c->slots, sizeof(uint64_t));
+    c->slotBases = (int *)growArray(NULL, c->slots, sizeof(int));
+    if (!c->slotKeys)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    soloBaseId(c, packSoloBase(soloBaseOf(from, p))); // base 0, where the player is
+
+    Game g; // the turns are played on a copy of the game, the other players stay where they are
+    initGame(&g, from->maze, 0, 0);
+    forkGame(&g, from, 0);
+    findBawanaOutcomes(c, &g, p);
+    const Maze *m = from->maze;
+    int startCell = cellIndex(m, m->startCells[p]);
+    c->no_Bawana = m->no_BawanaCells;
+
+    for (int base = 0; base < c->no_Bases; base++)
+    {
+        findTurnOutcomes(c, &g, p, base);
+        mergeTurnOutcomes(c, base);
+
+        // players walled in Bawana are out of reach, anyone else captured goes back to the start cell
+        SoloBase b = unpackSoloBase(c->baseKeys[base]);
+        int captured = base;
+        if (b.cell != startCell && cellTypeOf(m->cells[b.cell]) != BAWANA_CELL)
+        {
+            b.cell = startCell;
+            captured = soloBaseId(c, packSoloBase(b));
+        }
+        c->captured[base] = captured;
+    }
+    freeGame(&g);
+
+    // the bases grouped by throw count mod 4 - every turn moves a player on to the next group
+    c->baseCell = (int *)growArray(NULL, c->no_Bases, sizeof(int));
+    c->classBases = (int *)growArray(NULL, c->no_Bases, sizeof(int));
+    memset(c->classStart, 0, sizeof(c->classStart));
+    for (int base = 0; base < c->no_Bases; base++)
+    {
+        c->baseCell[base] = unpackSoloBase(c->baseKeys[base]).cell;
+        c->classStart[c->baseKeys[base] % 4 + 1]++;
+    }
+    for (int k = 0; k < 4; k++)
+    {
+        c->classStart[k + 1] += c->classStart[k];
+    }
+    int fill[4] = {c->classStart[0], c->classStart[1], c->classStart[2], c->classStart[3]};
+    for (int base = 0; base < c->no_Bases; base++)
+    {
+        c->classBases[fill[c->baseKeys[base] % 4]++] = base;
+    }
+}
+
+void freeSoloChain(SoloChain *c)
+{
+    free(c->baseKeys);
+    free(c->firstOutcome);
+    free(c->no_Outcomes);
+    free(c->winProb);
+    free(c->captured);
+    free(c->landStart);
+    free(c->slotKeys);
+    free(c->slotBases);
+    free(c->outcomes);
+    free(c->bawana);
+    free(c->landCells);
+    free(c->landProbs);
+    free(c->baseCell);
+    free(c->classBases);
+    *c = (SoloChain){0};
+}
+
+// whether the base has a way to the flag, searched backwards from the bases whose turn can capture it. running dry
+// goes through one of the 16 Bawana tables, taken as extra bases after the chain's, and a capture is a way to the
+// start cell
+bool soloFlagLive(const SoloChain *c, int from)
+{
+    int n = c->no_Bases + 16;
+    long edges = 2 * c->no_TurnOutcomes + c->no_Bases + 16L * c->no_Bawana;
+    int *edgeFrom = (int *)growArray(NULL, edges, sizeof(int));
+    int *edgeTo = (int *)growArray(NULL, edges, sizeof(int));
+    long count = 0;
+    for (int base = 0; base < c->no_Bases; base++)
+    {
+        for (int i = 0; i < c->no_Outcomes[base]; i++)
+        {
+            const TurnOutcome *o = &c->outcomes[c->firstOutcome[base] + i];
+            edgeFrom[count] = base;
+            edgeTo[count++] = o->base;
+            if (o->kind == OUTCOME_MOVE)
+            {
+                edgeFrom[count] = base;
+                edgeTo[count++] = c->no_Bases + o->dry;
+            }
+        }
+        edgeFrom[count] = base;
+        edgeTo[count++] = c->captured[base];
+    }
+    for (int i = 0; i < 16 * c->no_Bawana; i++)
+    {
+        edgeFrom[count] = c->no_Bases + i / c->no_Bawana;
+        edgeTo[count++] = c->bawana[i].base;
+    }
+
+    int *inStart = (int *)calloc(n + 1, sizeof(int));
+    int *inFrom = (int *)growArray(NULL, count, sizeof(int));
+    int *queue = (int *)growArray(NULL, n, sizeof(int));
+    bool *live = (bool *)calloc(n, sizeof(bool));
+    if (!inStart || !live)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    for (long i = 0; i < count; i++)
+    {
+        inStart[edgeTo[i] + 1]++;
+    }
+    for (int s = 0; s < n; s++)
+    {
+        inStart[s + 1] += inStart[s];
+    }
+    for (long i = 0; i < count; i++)
+    {
+        inFrom[inStart[edgeTo[i]]++] = edgeFrom[i];
+    }
+    for (int s = n; s > 0; s--)
+    { // back from the end of each base's ways in to their start
+        inStart[s] = inStart[s - 1];
+    }
+    inStart[0] = 0;
+
+    int head = 0, tail = 0;
+    for (int base = 0; base < c->no_Bases; base++)
+    {
+        if (c->winProb[base] > 0)
+        {
+            live[base] = true;
+            queue[tail++] = base;
+        }
+    }
+    while (head < tail)
+    {
+        int s = queue[head++];
+        for (int i = inStart[s]; i < inStart[s + 1]; i++)
+        {
+            if (!live[inFrom[i]])
+            {
+                live[inFrom[i]] = true;
+                queue[tail++] = inFrom[i];
+            }
+        }
+    }
+    bool reach = live[from];
+    free(edgeFrom);
+    free(edgeTo);
+    free(inStart);
+    free(inFrom);
+    free(queue);
+    free(live);
+    return reach;
+}
+
+// ----------------------------------------HITTING TIMES---------------------------------------
+// with Q the moves between states and x the chances of the states at the start, x Q^(t-1) winProb is the chance
+// the flag is captured in round t. summed over t it is the chance of ever getting there, and with t as weight the
+// expected rounds. the series is summed round by round until the chance of a round falls by the same factor every
+// 4 rounds - the turns cycle through the throw count mod 4 - and the geometric rest is added in closed form. the
+// factor is the largest eigenvalue of Q^4, so a few hundred passes over Q stand in for tens of thousands
+
+#define SOLVE_STEADY_ROUNDS 16 // rounds the 4 round factor must hold before the rest is taken as geometric
+#define SOLVE_TOLERANCE 1e-9   // relative change of the factor between rounds that still counts as holding
+
+typedef struct
+{
+    double *won;   // [round] chance the flag is captured in it, won[0] = 0
+    int rounds;    // rounds summed, after them every 4 rounds repeat the 4 before them times tail
+    double tail;
+    double reach;    // chance of ever capturing the flag
+    double expected; // expected rounds to capture it, given that it is captured
+} SoloTimes;
+
+// a player's chances in the chain being followed, and how far their 4 round factor has settled
+typedef struct
+{
+    double *x;    // [base * MP_LEVELS + level]
+    int throwMod; // the group of bases x is on
+    bool live;
+    int steady;
+    double factor;
+    double left;
+} ChainWalker;
+
+// the rounds summed, then for each of the last 4 of them b the rounds b + 4j, j >= 1, at won[b] tail^j
+void sumSoloTimes(SoloTimes *times)
+{
+    double reach = 0, sum = 0, q = times->tail;
+    int t = times->rounds;
+    for (int r = 1; r <= t; r++)
+    {
+        reach += times->won[r];
+        sum += r * times->won[r];
+    }
+    for (int b = t - 3; b <= t && q > 0; b++)
+    {
+        reach += times->won[b] * q / (1 - q);
+        sum += times->won[b] * (b * q / (1 - q) + 4 * q / ((1 - q) * (1 - q)));
+    }
+    times->reach = reach < 1 ? reach : 1; // the extrapolated rest can overshoot by the tolerance
+    times->expected = reach > 0 ? sum / reach : 0;
+}
+
+// the chance to the base, at the two levels around the points. the one above is added to even at a share of 0,
+// so the chances keep a level to spare after the last base
+void addPoints(double *x, int base, int mp, double prob)
+{
+    mp = mp < mpLevels[0] ? mpLevels[0] : mp > mpLevels[MP_LEVELS - 1] ? mpLevels[MP_LEVELS - 1] : mp;
+    double upper = mpUpperWeight[mp - mpLevels[0]];
+    double *at = x + (long)base * MP_LEVELS + mpLevelBelow[mp - mpLevels[0]];
+    at[0] += prob - prob * upper;
+    at[1] += prob * upper;
+}
+
+// one turn of a player: their chances move on from one group of bases to the next, and the cells the turn
+// captures on get the chance of it. alive is the chance the turn was played at all
+double stepChain(const SoloChain *c, ChainWalker *w, double *land, int entryCell, double *alive)
+{
+    int points[MP_LEVELS];
+    double mass[MP_LEVELS];
+    double dry[16] = {0}; // chance of running dry by Bawana table
+    double won = 0;
+    *alive = 0;
+    for (int i = c->classStart[w->throwMod]; i < c->classStart[w->throwMod + 1]; i++)
+    {
+        int base = c->classBases[i];
+        double *at = w->x + (long)base * MP_LEVELS;
+        int count = 0;
+        double sum = 0;
+        for (int level = 0; level < MP_LEVELS; level++)
+        {
+            if (at[level] != 0)
+            { // the turn takes it all to the next group, none comes back to the base
+                points[count] = mpLevels[level];
+                mass[count++] = at[level];
+                sum += at[level];
+                at[level] = 0;
+            }
+        }
+        if (count == 0)
+        {
+            continue;
+        }
+        *alive += sum;
+        won += sum * c->winProb[base];
+        for (int j = c->landStart[base]; j < c->landStart[base + 1]; j++)
+        {
+            land[c->landCells[j]] += sum * c->landProbs[j];
+        }
+        for (int j = 0; j < c->no_Outcomes[base]; j++)
+        {
+            const TurnOutcome *o = &c->outcomes[c->firstOutcome[base] + j];
+            if (o->kind == OUTCOME_SET)
+            {
+                addPoints(w->x, o->base, o->value, sum * o->prob);
+                continue;
+            }
+            double *to = w->x + (long)o->base * MP_LEVELS;
+            bool move = o->kind == OUTCOME_MOVE;
+            for (int k = 0; k < count; k++)
+            { // addPoints, with the base's row worked out once
+                int mp = points[k] + o->value;
+                double v = mass[k] * o->prob;
+                if (move && mp <= 0)
+                {
+                    dry[(int)o->dry] += v;
+                    continue;
+                }
+                mp = mp < mpLevels[0] ? mpLevels[0] : mp > mpLevels[MP_LEVELS - 1] ? mpLevels[MP_LEVELS - 1] : mp;
+                int level = mpLevelBelow[mp - mpLevels[0]];
+                double upper = mpUpperWeight[mp - mpLevels[0]];
+                to[level] += v - v * upper;
+                to[level + 1] += v * upper;
+            }
+        }
+    }
+    w->throwMod = (w->throwMod + 1) % 4;
+
+    for (int table = 0; table < 16; table++)
+    { // where running dry leaves a player does not depend on where they ran dry, so it is spread once
+        for (int k = 0; dry[table] > 0 && k < c->no_Bawana; k++)
+        {
+            BawanaOutcome b = c->bawana[table * c->no_Bawana + k];
+            addPoints(w->x, b.base, b.mp, dry[table] / c->no_Bawana);
+            land[entryCell] += b.entry ? dry[table] / c->no_Bawana : 0;
+        }
+    }
+    return won;
+}
+
+// the share of the player's chance on each cell that the player whose turn it was captures, sent to the start cell
+void captureChain(const SoloChain *c, ChainWalker *w, const double *land, double scale)
+{
+    for (int i = c->classStart[w->throwMod]; i < c->classStart[w->throwMod + 1]; i++)
+    {
+        int base = c->classBases[i];
+        double share = land[c->baseCell[base]] * scale;
+        if (share == 0 || c->captured[base] == base)
+        {
+            continue;
+        }
+        share = share < 1 ? share : 1; // a turn that lands on BawanaEntry and runs dry there counts it twice
+        double *at = w->x + (long)base * MP_LEVELS;
+        double *to = w->x + (long)c->captured[base] * MP_LEVELS;
+        for (int level = 0; level < MP_LEVELS; level++)
+        {
+            to[level] += at[level] * share;
+            at[level] -= at[level] * share;
+        }
+    }
+}
+
+// whether the player's 4 round factor has held long enough to take the rest of their rounds as geometric
+bool walkerSettled(ChainWalker *w, const double *won, int t)
+{
+    if (!w->live || w->left < 1e-15)
+    {
+        return true;
+    }
+    if (t < 8)
+    {
+        return false;
+    }
+    double block = won[t] + won[t - 1] + won[t - 2] + won[t - 3];
+    double before = won[t - 4] + won[t - 5] + won[t - 6] + won[t - 7];
+    double now = before > 0 ? block / before : 0;
+    bool holds = now > 0 && now < 1 && now - w->factor < SOLVE_TOLERANCE * now && w->factor - now < SOLVE_TOLERANCE * now;
+    w->steady = holds ? w->steady + 1 : 0;
+    w->factor = now;
+    return w->steady >= SOLVE_STEADY_ROUNDS;
+}
+
+// the players' chains side by side, a round at a time. after each turn a share of every other player's chance on a
+// cell goes to their start cell, the chance the player whose turn it was landed on the cell - as if where the
+// players are did not depend on each other, which is what keeps it to a chain per player. the rounds are summed
+// until every player's 4 round factor holds
+void followChains(const SoloChain *chains, ChainWalker *walkers, SoloTimes *times, int players, const Maze *m)
+{
+    int cells = m->floors * m->width * m->length;
+    int entryCell = cellIndex(m, BawanaEntry);
+    double *land = (double *)calloc(cells, sizeof(double));
+    if (!land)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    long capacity = 1024;
+    for (int p = 0; p < players; p++)
+    {
+        times[p].won = (double *)growArray(NULL, capacity, sizeof(double));
+        times[p].won[0] = 0;
+    }
+
+    int t = 0;
+    bool settled = false;
+    while (t < MAX_ROUNDS && !settled)
+    {
+        if (++t == capacity)
+        {
+            capacity *= 2;
+            for (int p = 0; p < players; p++)
+            {
+                times[p].won = (double *)growArray(times[p].won, capacity, sizeof(double));
+            }
+        }
+        for (int p = 0; p < players; p++)
+        {
+            double alive;
+            memset(land, 0, cells * sizeof(double));
+            times[p].won[t] = stepChain(&chains[p], &walkers[p], land, entryCell, &alive);
+            walkers[p].left -= times[p].won[t];
+            for (int q = 0; q < players && alive > 0; q++)
+            {
+                if (q != p)
+                {
+                    captureChain(&chains[q], &walkers[q], land, 1 / alive);
+                }
+            }
+        }
+        settled = true;
+        for (int p = 0; p < players; p++)
+        {
+            settled &= walkerSettled(&walkers[p], times[p].won, t);
+        }
+    }
+    for (int p = 0; p < players; p++)
+    {
+        times[p].rounds = t;
+        times[p].tail = walkers[p].live && walkers[p].steady >= SOLVE_STEADY_ROUNDS ? walkers[p].factor : 0;
+        sumSoloTimes(&times[p]);
+    }
+    free(land);
+}
+
+// x to the power n by squaring
+double powerOf(double x, long n)
+{
+    double result = 1;
+    for (; n > 0; n >>= 1, x *= x)
+    {
+        result *= n & 1 ? x : 1;
+    }
+    return result;
+}
+
+// chance the flag is captured in round t
+double wonIn(const SoloTimes *times, long t)
+{
+    if (t <= times->rounds)
+    {
+        return times->won[t];
+    }
+    long blocks = (t - times->rounds + 3) / 4;
+    return times->won[t - 4 * blocks] * powerOf(times->tail, blocks);
+}
+
+// ----------------------------------------ANALYSIS---------------------------------------
+
+// an estimate of each player's chance of getting to the flag, expected rounds to it, and chance of winning the game
+// before it is stopped at MAX_ROUNDS. it is not exact: the stairs flip at the chances of their flips every turn
+// rather than every 5 rounds, and the players meet only through captures, at the chances of landing on each other's
+// cells as if where they are did not depend on each other. on the shipped layout the chances of winning are within
+// 0.8 points of a 20000 game batch, and the expected rounds of the game 8% under it
+void runSolve(const Game *from)
+{
+    int players = from->players.count;
+    SoloChain *chains = (SoloChain *)calloc(players, sizeof(SoloChain));
+    ChainWalker *walkers = (ChainWalker *)calloc(players, sizeof(ChainWalker));
+    SoloTimes *times = (SoloTimes *)calloc(players, sizeof(SoloTimes));
+    double *wins = (double *)calloc(players, sizeof(double));
+    double *still = (double *)growArray(NULL, players, sizeof(double));
+    double *after = (double *)growArray(NULL, players + 1, sizeof(double));
+    if (!chains || !walkers || !times || !wins)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    if (from->winner != NO_WINNER)
+    {
+        char name[NAME_STR_SIZE];
+        printf("\nThe game is over, %s captured the flag.\n", playerName(from->winner, name));
+        exit(1);
+    }
+
+    printf("\nApproximate chains of %d players from round %d, the stairs at the chances of their flips every turn and captures at the chances of landing on each other:\n", players, from->gameRound);
+    printf("  %-7s %10s %12s %10s\n", "player", "bases", "outcomes", "time(s)");
+    double started = nowSeconds();
+    for (int p = 0; p < players; p++)
+    {
+        double start = nowSeconds();
+        buildSoloChain(&chains[p], from, p);
+        walkers[p].x = (double *)calloc((long)chains[p].no_Bases * MP_LEVELS + 1, sizeof(double));
+        if (!walkers[p].x)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+        addPoints(walkers[p].x, 0, from->players.movementPoints[p], 1); // base 0 is where the player is
+        walkers[p].throwMod = from->players.throwsCount[p] % 4;
+        walkers[p].live = soloFlagLive(&chains[p], 0);
+        walkers[p].left = 1;
+
+        char name[NAME_STR_SIZE];
+        printf("  %-7s %10d %12ld %10.2f\n", playerName(p, name), chains[p].no_Bases, chains[p].no_TurnOutcomes, nowSeconds() - start);
+        fflush(stdout);
+    }
+    double start = nowSeconds();
+    followChains(chains, walkers, times, players, from->maze);
+    printf("\n  %-7s %12s %14s\n", "player", "reach flag", "rounds to it");
+    for (int p = 0; p < players; p++)
+    {
+        char name[NAME_STR_SIZE], expected[24];
+        snprintf(expected, sizeof(expected), times[p].reach > 0 ? "%.1f" : "never", times[p].expected);
+        printf("  %-7s %11.4f%% %14s\n", playerName(p, name), 100 * times[p].reach, expected);
+    }
+    printf("  followed for %d rounds in %.2f s\n", times[0].rounds, nowSeconds() - start);
+
+    // p wins round t if they capture the flag in it, the players before them have not by the end of it and the
+    // ones after them had not by the end of the round before
+    int rounds = MAX_ROUNDS - from->gameRound;
+    double expectedRounds = 0, nobody = 1;
+    for (int p = 0; p < players; p++)
+    {
+        still[p] = 1;
+    }
+    for (long t = 1; t <= rounds; t++)
+    {
+        expectedRounds += nobody;
+        after[players] = 1; // after[p] is the product of still over the players after p
+        for (int p = players - 1; p >= 0; p--)
+        {
+            after[p] = after[p + 1] * still[p];
+        }
+        double before = 1; // players before p, at the end of this round
+        for (int p = 0; p < players; p++)
+        {
+            double won = wonIn(&times[p], t);
+            wins[p] += won * before * after[p + 1];
+            still[p] -= won;
+            before *= still[p];
+        }
+        nobody = before;
+    }
+
+    printf("\nEstimated chance of winning before the game is stopped after %d rounds, approximate as the chains are:\n", MAX_ROUNDS);
+    for (int p = 0; p < players; p++)
+    {
+        char name[NAME_STR_SIZE];
+        printf("  %-7s %9.4f%%\n", playerName(p, name), 100 * wins[p]);
+    }
+    printf("  %-7s %9.4f%%\n", "nobody", 100 * nobody);
+    printf("  estimated rounds of the game: %.1f, solved in %.2f s\n", from->gameRound + expectedRounds, nowSeconds() - started);
+
+    for (int p = 0; p < players; p++)
+    {
+        free(times[p].won);
+        free(walkers[p].x);
+        freeSoloChain(&chains[p]);
+    }
+    free(chains);
+    free(walkers);
+    free(times);
+    free(wins);
+    free(still);
+    free(after);
+}
+
+#endif
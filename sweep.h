@@ -0,0 +1,379 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "sim.h"
+
+// ----------------------------------------LAYOUT SWEEP---------------------------------------
+// a sweep file names the layouts to compare, one option a line, '#' starts a comment:
+//   flag [floor, width, length]
+//   walls <file>, stairs <file>, poles <file>
+//   seed <n>
+// every combination of the options is a variant, a kind without a line keeps flag.txt, walls.txt, stairs.txt,
+// poles.txt or seed.txt. lines "variant [floor, width, length] <walls> <stairs> <poles>" list the layouts one by
+// one instead, and each is played with every seed. every object file is read once, however many variants lay it,
+// and the maze size and areas of maze.txt are read once for all of them
+
+#define MAX_SWEEP_OPTIONS 64 // lines of one kind
+#define SWEEP_LINE_SIZE 1024
+#define SWEEP_PATH_SIZE 256
+
+typedef struct
+{
+    char path[SWEEP_PATH_SIZE];
+    EntryList entries;
+} SweepFile;
+
+typedef struct
+{
+    CellCord flag;
+    int walls; // files index of each object file
+    int stairs;
+    int poles;
+} SweepLayout;
+
+typedef struct
+{
+    SweepFile *files;
+    int no_Files;
+    int fileCapacity;
+
+    CellCord flags[MAX_SWEEP_OPTIONS];
+    int objectFiles[3][MAX_SWEEP_OPTIONS]; // [walls, stairs, poles] files index
+    unsigned int seeds[MAX_SWEEP_OPTIONS];
+    int no_Flags;
+    int no_ObjectFiles[3];
+    int no_Seeds;
+
+    SweepLayout *layouts;
+    int no_Layouts;
+    int layoutCapacity;
+} Sweep;
+
+const char *sweepKinds[3] = {"walls", "stairs", "poles"};
+const int sweepWidths[3] = {5, 6, 4}; // integers in an entry of each kind
+
+// the file read for the kind, read now if no earlier option named it
+int sweepFile(Sweep *s, const char *path, int kind)
+{
+    for (int i = 0; i < s->no_Files; i++)
+    {
+        if (strcmp(s->files[i].path, path) == 0 && s->files[i].entries.width == sweepWidths[kind])
+        {
+            return i;
+        }
+    }
+    if (s->no_Files == s->fileCapacity)
+    {
+        s->fileCapacity = s->fileCapacity ? 2 * s->fileCapacity : 16;
+        s->files = (SweepFile *)realloc(s->files, s->fileCapacity * sizeof(SweepFile));
+        if (!s->files)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+    SweepFile *f = &s->files[s->no_Files];
+    snprintf(f->path, sizeof(f->path), "%s", path);
+    if (!readEntryList(&f->entries, path, sweepWidths[kind]))
+    {
+        printf("\nError: Could not open %s file %s\n", sweepKinds[kind], path);
+        exit(1);
+    }
+    return s->no_Files++;
+}
+
+void addSweepLayout(Sweep *s, SweepLayout layout)
+{
+    if (s->no_Layouts == s->layoutCapacity)
+    {
+        s->layoutCapacity = s->layoutCapacity ? 2 * s->layoutCapacity : 64;
+        s->layouts = (SweepLayout *)realloc(s->layouts, s->layoutCapacity * sizeof(SweepLayout));
+        if (!s->layouts)
+        {
+            printf("\nError: Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+    s->layouts[s->no_Layouts++] = layout;
+}
+
+void addSweepOption(int *count, int line)
+{
+    if (*count == MAX_SWEEP_OPTIONS)
+    {
+        printf("\nError: Line %d of the sweep file: at most %d options of a kind.\n", line, MAX_SWEEP_OPTIONS);
+        exit(1);
+    }
+    (*count)++;
+}
+
+void loadSweep(Sweep *s, const char *path, unsigned int seed)
+{
+    memset(s, 0, sizeof(*s));
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        printf("\nError: Could not open %s\n", path);
+        exit(1);
+    }
+
+    char text[SWEEP_LINE_SIZE], name[SWEEP_PATH_SIZE], files[3][SWEEP_PATH_SIZE];
+    CellCord flag;
+    int line = 0;
+    while (fgets(text, sizeof(text), file))
+    {
+        line++;
+        char *comment = strchr(text, '#');
+        if (comment)
+        {
+            *comment = '\0';
+        }
+        int kind = -1, n = 0;
+        char word[16] = "";
+        sscanf(text, " %15s%n", word, &n);
+        for (int k = 0; k < 3; k++)
+        {
+            kind = strcmp(word, sweepKinds[k]) == 0 ? k : kind;
+        }
+
+        if (word[0] == '\0')
+        {
+            continue;
+        }
+        else if (kind >= 0 && sscanf(text + n, " %255s", name) == 1)
+        {
+            int f = sweepFile(s, name, kind);
+            s->objectFiles[kind][s->no_ObjectFiles[kind]] = f;
+            addSweepOption(&s->no_ObjectFiles[kind], line);
+        }
+        else if (strcmp(word, "flag") == 0 && sscanf(text + n, " [%d, %d, %d]", &flag.floor, &flag.width, &flag.length) == 3)
+        {
+            s->flags[s->no_Flags] = flag;
+            addSweepOption(&s->no_Flags, line);
+        }
+        else if (strcmp(word, "seed") == 0 && sscanf(text + n, " %u", &s->seeds[s->no_Seeds]) == 1)
+        {
+            addSweepOption(&s->no_Seeds, line);
+        }
+        else if (strcmp(word, "variant") == 0 &&
+                 sscanf(text + n, " [%d, %d, %d] %255s %255s %255s", &flag.floor, &flag.width, &flag.length, files[0], files[1], files[2]) == 6)
+        {
+            addSweepLayout(s, (SweepLayout){flag, sweepFile(s, files[0], 0), sweepFile(s, files[1], 1), sweepFile(s, files[2], 2)});
+        }
+        else
+        {
+            printf("\nError: Line %d of %s is not a sweep option.\n", line, path);
+            fclose(file);
+            exit(1);
+        }
+    }
+    fclose(file);
+
+    if (s->no_Seeds == 0)
+    {
+        s->seeds[s->no_Seeds++] = seed;
+    }
+    if (s->no_Layouts > 0)
+    {
+        return;
+    }
+
+    // the grid of the options, a kind without any takes the game's own file
+    const char *defaults[3] = {"walls.txt", "stairs.txt", "poles.txt"};
+    for (int k = 0; k < 3; k++)
+    {
+        if (s->no_ObjectFiles[k] == 0)
+        {
+            s->objectFiles[k][s->no_ObjectFiles[k]++] = sweepFile(s, defaults[k], k);
+        }
+    }
+    if (s->no_Flags == 0)
+    {
+        FILE *flagFile = fopen("flag.txt", "r");
+        if (!flagFile || !readFlag(flagFile, &s->flags[0]))
+        {
+            printf("\nError: The sweep names no flag and flag.txt can not be read.\n");
+            exit(1);
+        }
+        fclose(flagFile);
+        s->no_Flags = 1;
+    }
+    for (int f = 0; f < s->no_Flags; f++)
+    {
+        for (int w = 0; w < s->no_ObjectFiles[0]; w++)
+        {
+            for (int st = 0; st < s->no_ObjectFiles[1]; st++)
+            {
+                for (int p = 0; p < s->no_ObjectFiles[2]; p++)
+                {
+                    addSweepLayout(s, (SweepLayout){s->flags[f], s->objectFiles[0][w], s->objectFiles[1][st], s->objectFiles[2][p]});
+                }
+            }
+        }
+    }
+}
+
+void freeSweep(Sweep *s)
+{
+    for (int i = 0; i < s->no_Files; i++)
+    {
+        freeEntryList(&s->files[i].entries);
+    }
+    free(s->files);
+    free(s->layouts);
+    s->files = NULL;
+    s->layouts = NULL;
+}
+
+// ----------------------------------------SWEEP RESULTS---------------------------------------
+
+typedef struct
+{
+    const char *fault; // NULL if the variant was played, else why it could not be
+    int leftOut;       // objects the rules left out
+    BatchStats stats;
+    int p95Rounds;
+    double elapsed;
+} SweepResult;
+
+int compareRounds(const void *a, const void *b) { return *(const int *)a - *(const int *)b; }
+
+// lay out one variant on a maze of the shared size, check every player can reach its flag and play the games
+SweepResult runSweepVariant(const Maze *size, const Sweep *s, const SweepLayout *layout, unsigned int seed,
+                            long games, int threads, int players, int *rounds)
+{
+    SweepResult r = {NULL};
+    double start = nowSeconds();
+    Maze m = {0};
+    copyMazeSize(&m, size);
+
+    MazeLayout mazeLayout = {layout->flag, &s->files[layout->walls].entries, &s->files[layout->stairs].entries, &s->files[layout->poles].entries};
+    bool laid = layMaze(&m, seed, &mazeLayout);
+    r.leftOut = (m.walls ? mazeLayout.walls->count - m.no_Walls : 0) + (m.stairs ? mazeLayout.stairs->count - m.no_Stairs : 0) +
+                (m.poles ? mazeLayout.poles->count - m.no_Poles : 0);
+    if (!laid)
+    {
+        r.fault = !m.walls ? "flag cell taken" : m.no_Walls == 0 ? "no valid walls" : m.no_Stairs == 0 ? "no valid stairs" : "no valid poles";
+        freeMaze(&m);
+        return r;
+    }
+    if (players != DEFAULT_PLAYERS)
+    {
+        placePlayers(&m, players, seed);
+    }
+    buildStepTable(&m);
+    r.fault = isFlagReachableFromStarts(&m, seed) ? NULL : "flag unreachable";
+
+    if (!r.fault)
+    {
+        r.stats = runBatch(&m, seed, games, threads, NULL, rounds);
+        qsort(rounds, games, sizeof(int), compareRounds);
+        r.p95Rounds = rounds[(games * 95 + 99) / 100 - 1];
+    }
+    freeMaze(&m);
+    r.elapsed = nowSeconds() - start;
+    return r;
+}
+
+// play every variant of the sweep file and report them side by side, and as tab separated values into outPath
+void runSweep(const char *path, unsigned int seed, long games, int threads, int players, const char *outPath)
+{
+    Sweep *s = (Sweep *)malloc(sizeof(Sweep));
+    int *rounds = (int *)malloc(games * sizeof(int));
+    if (!s || !rounds)
+    {
+        printf("\nError: Memory allocation failed.\n");
+        exit(1);
+    }
+    loadSweep(s, path, seed);
+    FILE *out = outPath ? fopen(outPath, "w") : NULL;
+    if (outPath && !out)
+    {
+        printf("\nError: Could not write %s\n", outPath);
+        exit(1);
+    }
+
+    Maze size = {0};
+    loadMazeSize(&size);
+    int shown = players < STATS_PLAYERS ? players : STATS_PLAYERS;
+    char name[NAME_STR_SIZE];
+
+    printf("\nSweep of %s: %d layouts x %d seeds, %ld games each on %d threads\n", path, s->no_Layouts, s->no_Seeds, games, threads);
+    printf("  %4s %-12s %-14s %-14s %-14s %10s %5s", "#", "flag", "walls", "stairs", "poles", "seed", "out");
+    if (out)
+    {
+        fprintf(out, "variant\tflag\twalls\tstairs\tpoles\tseed\tleft_out\tfault");
+    }
+    for (int p = 0; p < shown; p++)
+    {
+        printf(" %6s%%", playerName(p, name));
+        if (out)
+        {
+            fprintf(out, "\twin_%s", playerName(p, name));
+        }
+    }
+    printf(" %7s %9s %8s %8s\n", "unfin%", "mean", "p95", "bawana");
+    if (out)
+    {
+        fprintf(out, "\tunfinished\tmean_rounds\tp95_rounds\tbawana_per_game\tseconds\n");
+    }
+
+    double start = nowSeconds();
+    int variant = 0;
+    for (int l = 0; l < s->no_Layouts; l++)
+    {
+        for (int k = 0; k < s->no_Seeds; k++, variant++)
+        {
+            const SweepLayout *layout = &s->layouts[l];
+            fprintf(stderr, "Sweep variant %d:\n", variant); // the objects it leaves out are logged under it
+            SweepResult r = runSweepVariant(&size, s, layout, s->seeds[k], games, threads, players, rounds);
+
+            char flag[32];
+            snprintf(flag, sizeof(flag), "[%d,%d,%d]", layout->flag.floor, layout->flag.width, layout->flag.length);
+            const char *files[3] = {s->files[layout->walls].path, s->files[layout->stairs].path, s->files[layout->poles].path};
+            printf("  %4d %-12s %-14s %-14s %-14s %10u %5d", variant, flag, files[0], files[1], files[2], s->seeds[k], r.leftOut);
+            if (out)
+            {
+                fprintf(out, "%d\t%s\t%s\t%s\t%s\t%u\t%d\t%s", variant, flag, files[0], files[1], files[2], s->seeds[k], r.leftOut, r.fault ? r.fault : "");
+            }
+            if (r.fault)
+            {
+                printf("  not played: %s\n", r.fault);
+                if (out)
+                {
+                    fprintf(out, "\n");
+                }
+                continue;
+            }
+
+            const BatchStats *b = &r.stats;
+            for (int p = 0; p < shown; p++)
+            {
+                printf(" %7.2f", 100.0 * b->wins[p] / b->games);
+                if (out)
+                {
+                    fprintf(out, "\t%.4f", (double)b->wins[p] / b->games);
+                }
+            }
+            double mean = (double)b->totalRounds / b->games, bawana = (double)b->bawanaVisits / b->games;
+            printf(" %7.2f %9.1f %8d %8.1f\n", 100.0 * b->unfinished / b->games, mean, r.p95Rounds, bawana);
+            if (out)
+            {
+                fprintf(out, "\t%.4f\t%.2f\t%d\t%.2f\t%.3f\n", (double)b->unfinished / b->games, mean, r.p95Rounds, bawana, r.elapsed);
+            }
+        }
+    }
+    printf("  %d variants in %.3f s, %d object files read\n", variant, nowSeconds() - start, s->no_Files);
+    if (out)
+    {
+        fclose(out);
+        printf("  results written to %s\n", outPath);
+    }
+
+    free(size.areas);
+    freeSweep(s);
+    free(s);
+    free(rounds);
+}
+
+#endif
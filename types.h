@@ -4,12 +4,36 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include "rng.h"
+#include "parse.h"
+#include "profile.h"
 
 // --------------------constants--------------------
-#define FLOORS 3
-#define WIDTH 10
-#define LENGTH 25
-#define NO_PLAYERS 3
+#define DEFAULT_PLAYERS 3 // A, B and C in the places of the original game
+#define MAX_PLAYERS 16384  // player indexes fit in the int16_t of an event
+#define MAX_MOVE_STEPS 12 // a triggered player moves twice the dice
+
+#define DEFAULT_FLOORS 3 // maze size used when maze.txt is missing
+#define DEFAULT_WIDTH 10
+#define DEFAULT_LENGTH 25
+#define MIN_WIDTH 10  // the starting area and Bawana sit in rows 6 to 9 of the ground floor
+#define MIN_LENGTH 25 // and in lengths 8 to 24
+
+#define CORD_STR_SIZE 20 // size of the buffer cordToString writes into
+#define NAME_STR_SIZE 12 // size of the buffer playerName writes into
+#define NO_WINNER -1
+
+// hand an event to the game's sink. a silent game has no sink and builds nothing
+#define EMIT(g, ...)                                       \
+    do                                                     \
+    {                                                      \
+        if ((g)->sink)                                     \
+        {                                                  \
+            GameEvent event_ = __VA_ARGS__;                \
+            (g)->sink->write((g)->sink->context, &event_); \
+        }                                                  \
+    } while (0)
 
 // --------------------enums--------------------
 typedef enum
@@ -67,6 +91,52 @@ typedef enum
     RANDOM_CELL
 } BawanaCellType;
 
+typedef enum
+{
+    STEP_DONE,    // all steps taken
+    STEP_BLOCKED, // a wall or the maze boundary is in the way, the move is not possible
+    STEP_STAIR,   // stopped on a stair cell, it depends on the game's stair direction
+    STEP_FLAG     // reached the flag
+} StepStop;
+
+// what happened in a game, in the order it happened. the sink that receives them decides how to tell them
+typedef enum
+{
+    EVENT_ROUND,            // a round starts, value is its number
+    EVENT_TURN,             // player's turn starts
+    EVENT_STAIRS_CHANGED,   // the stair directions were shuffled
+    EVENT_CUT_OFF,          // player can not reach the flag with the current stair directions
+    EVENT_STAY_IN_START,    // player rolled dice and stays in the starting area
+    EVENT_ENTER_MAZE,       // player rolled a 6 and enters the maze
+    EVENT_POISON_WAIT,      // player is food poisoned and misses the turn
+    EVENT_POISON_OVER,      // player recovered, value is the Bawana cell type now applied
+    EVENT_DISORIENTED_ROLL, // player is disoriented, rolled dice and moves in dir
+    EVENT_DISORIENTED_OVER,
+    EVENT_TRIGGERED_ROLL,   // player is triggered, rolled dice and moves steps cells in dir
+    EVENT_TRIGGERED_OVER,
+    EVENT_STAIR,            // player landed on a stair at from and took it to to
+    EVENT_POLE,             // player landed on a pole at from and slid down to to
+    EVENT_MOVE,             // player rolled dice, and the direction dice if rolled, and moved steps cells in dir to to
+    EVENT_BLOCKED,          // as EVENT_MOVE, but the way is blocked and player stays at to
+    EVENT_CAPTURE,          // player was captured by other at to and sent back to the start
+    EVENT_DEPLETED,         // player ran out of movement points and is sent to a Bawana cell of type value
+    EVENT_BAWANA,           // player ate at a Bawana cell of type value and got mp movement points
+    EVENT_BACK_TO_START,    // player walked into the starting area and is put back on to, facing dir
+    EVENT_MOVE_DONE,        // player moved steps cells for value movement points, has mp left and faces dir
+    EVENT_WIN,              // player captured the flag at to
+    EVENT_GAME_END          // a game of a batch ended after value rounds, won by player or unfinished if it is NO_WINNER
+} EventKind;
+
+typedef enum
+{
+    NO_OWNER,
+    SPECIAL_OWNER, // a special cell: starting positions, Bawana entry
+    FLAG_OWNER,
+    WALL_OWNER,
+    STAIR_OWNER,
+    POLE_OWNER
+} OwnerKind;
+
 // --------------------structs--------------------
 typedef struct
 {
@@ -75,13 +145,13 @@ typedef struct
     int length;
 } CellCord;
 
-struct Cell
-{
-    CellType cellType;
-    int cellTypeId;
-    MPEffectType effectType;
-    int effectValue;
-};
+// a maze cell packed into 16 bits. the low 4 bits hold the CellType, the other 12 depend on it: stair, pole and
+// bawana cells keep their object id + 1, active cells their movement point effect (2 bits) and its value (3 bits)
+typedef uint16_t Cell;
+
+#define CELL_TYPE_BITS 4
+#define CELL_TYPE_MASK 0xF
+#define MAX_CELL_ID 0xFFE // highest object id a cell can hold
 
 struct Stair
 {
@@ -92,7 +162,6 @@ struct Stair
     int endFloor;
     int endBlockWidth;
     int endBlockLength;
-    StairDirection dir;
 };
 
 struct Pole
@@ -120,30 +189,126 @@ struct BawanaCell
     int movementPoints;
 };
 
+// every player of a game, one array per field so a pass over the players reads only the fields it needs. players
+// are known by their index, their start cells and directions are the maze's
 typedef struct
 {
-    char name;
-    CellCord currentCell; // current location of the player
-    CellCord startCell;   // player's starting location in starting area
-    Direction startDir;   // player's direction when in starting area
-    Direction dir;
-    int movementPoints;
-    int throwsCount;
-    PlayerStatus status;
-    int throwsLeftInStatus;
-} Player;
+    int count;
+    CellCord *currentCell;
+    int *movementPoints;
+    Direction *dir;
+    PlayerStatus *status;
+    int *throwsCount;
+    int *throwsLeftInStatus;
+
+    int *occupant; // [cell index] first player on the cell, -1 for none
+    int *next;     // [player] the other players on the same cell, -1 ends the list
+    int *prev;
+    int *captured; // room for the players captured at once
+} Players;
 
 typedef struct
 {
-    char player;
+    int player;
     int steps;
     Direction dir;
     CellCord currentCell;
     int movementPoints;
     int mpMultiplyer;
-    char msgBuffer[600];
 } Move;
 
+// a stair or pole ride between two walking regions
+struct RegionEdge
+{
+    int from;
+    int to;
+};
+
+#define RIDE_UP 1   // start -> end can be taken
+#define RIDE_DOWN 2 // end -> start can be taken
+
+// walking regions at the two ends of a stair and the rides between them for each StairDirection. an end
+// overwritten by a later object can not be left from, and a stair inside one region gives no rides
+struct StairLink
+{
+    int startRegion;
+    int endRegion;
+    unsigned char rides[3];
+};
+
+// precomputed result of moving a number of steps from a cell in one direction
+struct StepEntry
+{
+    int dest;       // cell index where the player ends up (or the stair cell it stopped on)
+    int mpMultiply; // product of the multiplier cells on the way
+    short mpAdd;    // sum of the consume/add cells on the way
+    char steps;     // steps taken before stopping
+    char stop;      // StepStop
+};
+
+// a rectangle of active cells, a floor is the union of its areas and every other cell of it is empty
+struct FloorArea
+{
+    int floor;
+    int startBlockWidth;
+    int startBlockLength;
+    int endBlockWidth;
+    int endBlockLength;
+};
+
+// one block of memory handed out front to back and released as a whole
+typedef struct
+{
+    char *base;
+    size_t size;
+    size_t used;
+} Arena;
+
+// one event, only the fields its kind uses are set
+typedef struct
+{
+    uint8_t kind;   // EventKind
+    int16_t player; // index
+    int16_t other;
+    bool rolled; // the direction dice was rolled this turn
+    int8_t dir;  // Direction
+    int8_t facing;
+    int8_t dice;
+    int16_t steps;
+    int value;
+    int mp;
+    CellCord from;
+    CellCord to;
+} GameEvent;
+
+// where the events of a game go, write formats or stores them as it likes
+typedef struct
+{
+    void (*write)(void *context, const GameEvent *event);
+    void *context;
+} EventSink;
+
+// union-find over the blocked cells of every floor, 8 connected, with one more set per floor for the outside
+// of the maze. finds do not compress paths, so the unions since the last mark can be undone
+typedef struct
+{
+    int *parent; // [cell index, then one per floor] -1 for a walkable cell
+    int *size;
+    int *undo; // a root attached to another one, or ~cell for a cell that was blocked
+    int no_Undo;
+    int *linkHead;         // [cell index] first stair or pole link from the cell, -1 for none
+    int *linkNext;         // [link]
+    int *linkTo;           // [link] cell at the other end
+    int no_Links;
+    int *flood;            // [cell index] stamp of the last search that reached the cell
+    int *queue;            // [cell index] cells of a search
+    int *from;             // [cell index] cell the search came from
+    int floodStamp;
+    unsigned char *onPath; // [cell index] on the paths the last search found from the flag to a start and BawanaEntry
+    int *path;             // the cells marked in onPath
+    int no_Path;           // -1 while no path is known
+} BlockedSets;
+
 // ----------------------------------------GLOBAL VARIABLES---------------------------------------
 // constants
 extern const CellCord BawanaEntry;
@@ -154,23 +319,94 @@ extern const char *stringDirections[];
 
 extern const char *stringBawanaEffects[];
 
-// arrays
-extern struct Cell maze[FLOORS][WIDTH][LENGTH];
-extern Player players[NO_PLAYERS];
+// ----------------------------------------GAME CONTEXT---------------------------------------
+// the loaded maze and its objects, read only once intializeMaze is done so many games can share it
+typedef struct
+{
+    int floors;
+    int width;
+    int length;
+    int rowWords; // 64 bit words holding one packed row of a floor
+    int noCells;
+    struct FloorArea *areas;
+    int no_Areas;
+
+    Arena arena;     // the grid below: cells, walkable rows and regions in one block
+    Cell *cells;     // [cell index]
+    CellCord Flag;
+
+    struct Stair *stairs;
+    struct Pole *poles;
+    struct Wall *walls;
+    struct BawanaCell *bawanaCells;
+
+    int no_Stairs;
+    int no_Poles;
+    int no_Walls;
+    int no_BawanaCells;
+
+    struct StepEntry *stepTable; // [cell][direction][steps - 1], NULL if not built
+
+    uint64_t *walkable; // [floor][width][rowWords] packed rows, bit l set if the cell is not a wall or empty
+
+    int *region;    // [cell index] walking region, cells joined without stairs or poles, -1 if blocked
+    int no_Regions;
+    struct StairLink *stairLinks;  // [stairId]
+    struct RegionEdge *poleEdges;  // pole rides that change region, poles never change so these are fixed
+    int no_PoleEdges;
+
+    uint32_t *owner;     // [cell index] object holding the cell and its line while the objects load, NULL afterwards
+    BlockedSets blocked; // while the walls load, parent is NULL afterwards
 
-extern CellCord Flag;
+    MappedFile snapshot; // when loaded from a snapshot every array above points into this read only mapping
 
-// array pointers
-extern struct Stair *stairs;
-extern struct Pole *poles;
-extern struct Wall *walls;
-extern struct BawanaCell *bawanaCells;
+    int no_Players;       // players of every game on the maze
+    CellCord *startCells; // [player] where the player starts and is sent back to, in the starting area
+    Direction *startDirs; // [player] direction the player leaves the starting area in
+} Maze;
 
-// counters
-extern int no_Stairs;
-extern int no_Poles;
-extern int no_Walls;
-extern int no_BawanaCells;
+// which walking regions can reach the flag under a game's stair directions, kept up to date across stair flips
+typedef struct
+{
+    bool *regionReachesFlag;
+    StairDirection *trackedDirs; // stair directions regionReachesFlag was worked out for
+    struct RegionEdge *edges;    // buffers of the region graph search, allocated once per game
+    int *edgeHead;
+    int *edgeNext;
+    int *queue;
+    long searches;               // region graph searches, flips that could not change anything skip it
+    int unwinnableRounds;        // rounds that started with some player cut off from the flag
+    int unwinnableStretches;     // runs of consecutive such rounds
+    bool cutOff;                 // the last round was one of them
+} FlagTracker;
+
+#define MAX_SCRIPT_ROLLS 16 // more than the rolls of any turn
+
+// rolls handed to a game in place of its rng, and the range of every roll the game asked for
+typedef struct
+{
+    int rolls[MAX_SCRIPT_ROLLS];
+    int ranges[MAX_SCRIPT_ROLLS];
+    int given; // rolls past these are 0
+    int used;
+    bool rollStairs;   // a stair points the way a roll of the script says, rolled the first time the turn takes it
+    int no_StairRolls; // stairs the turn has rolled a direction for
+    int stairIds[MAX_SCRIPT_ROLLS];
+    StairDirection stairDirs[MAX_SCRIPT_ROLLS];
+} DiceScript;
 
-extern int gameRound;
+// everything that changes while a single game is played
+typedef struct
+{
+    const Maze *maze;
+    Players players;
+    StairDirection *stairDirs; // current direction of each stair, indexed by stairId
+    int gameRound;
+    int bawanaVisits;          // times a player ate at a Bawana cell this game
+    Rng rng;                   // dice stream of this game, keyed by seed and game index
+    FlagTracker tracker;
+    const EventSink *sink; // receives the events of the game, NULL for a silent one
+    DiceScript *script;    // NULL unless every outcome of a turn is being walked
+    int winner; // index of the player who captured the flag, NO_WINNER while the game is running
+} Game;
 #endif
\ No newline at end of file